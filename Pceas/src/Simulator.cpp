@@ -29,6 +29,7 @@
 #include <iostream>
 
 #include "core/Party.h"
+#include "communication/SessionMultiplexer.h"
 #include "circuit/CircuitGenerator.cpp"
 #include "SimulatorOptions.cpp"
 
@@ -45,67 +46,93 @@ using namespace pceas;
  * Each round, parties will
  * 1. Process incoming messages
  * 2. Send outgoing messages (one per party + one broadcast)
+ *
+ * A party may run several sessions concurrently (one 'Party' per session). Messages of all its sessions
+ * are sent together in the same round (see 'SessionMultiplexer').
  */
-void synchronizer(Party** parties, ulong partyCount, ConsensusBroadcast* cb) {
+void synchronizer(vector<Party**> const& sessions, SessionMultiplexer** muxes, ulong partyCount, ConsensusBroadcast* cb) {
 	unsigned long rounds = 0;
+	unsigned long privateMessages = 0;//messages between distinct parties (a batch message counts as one)
+	unsigned long broadcastMessages = 0;
 	while (true) {
 		bool done = true;
-		for (ulong i = 0; i < partyCount; ++i) {
-			done &= parties[i]->done;
+		for (auto const& parties : sessions) {
+			for (ulong i = 0; i < partyCount; ++i) {
+				done &= parties[i]->done;
+			}
 		}
 		if (done) {
 #ifdef VERBOSE
-			for (ulong i = 0; i < partyCount; ++i) {//print internal states of parties
-				stringstream ss;
-				parties[i]->print(ss);
-				cout << ss.str() << endl;
+			for (auto const& parties : sessions) {
+				for (ulong i = 0; i < partyCount; ++i) {//print internal states of parties
+					stringstream ss;
+					parties[i]->print(ss);
+					cout << ss.str() << endl;
+				}
 			}
 #endif
+			cout << "Rounds : " << rounds << ", private messages : " << privateMessages << ", broadcast messages : " << broadcastMessages << endl;
 			return;
 		}
-		//Synchronizer will wait until all parties become 'interactive'
-		for (ulong i = 0; i < partyCount; ++i) {
-			unique_lock<mutex> lk(parties[i]->m);
-			if (!parties[i]->done) {
-				parties[i]->cv.wait(lk, [parties, i]{return parties[i]->interactive;});
+		//Synchronizer will wait until all parties (in all sessions) become 'interactive'
+		for (auto const& parties : sessions) {
+			for (ulong i = 0; i < partyCount; ++i) {
+				unique_lock<mutex> lk(parties[i]->m);
+				if (!parties[i]->done) {
+					parties[i]->cv.wait(lk, [parties, i]{return parties[i]->interactive;});
+				}
 			}
 		}
-		for (ulong i = 0; i < partyCount; ++i) {
-			lock_guard<mutex> lk(parties[i]->m);
-			if (!parties[i]->done) {
-				parties[i]->interactive = false;
+		for (auto const& parties : sessions) {
+			for (ulong i = 0; i < partyCount; ++i) {
+				lock_guard<mutex> lk(parties[i]->m);
+				if (!parties[i]->done) {
+					parties[i]->interactive = false;
+				}
 			}
 		}
 		rounds++;
 		cout << "**************************************************************" << endl;
 		cout << "Transmitting messages. Round : " << rounds << endl;
+		for (ulong i = 0; i < partyCount; ++i) {
+			muxes[i]->pack(cb);//messages of all sessions of a party share the channels
+		}
 		cb->swapToFuture();//transmit broadcast messages
 		for (ulong i = 0; i < partyCount; ++i) {
 			for (ulong j = 0; j < partyCount; ++j) {
-				parties[i]->channels[j]->swapToFuture();//transmit private messages 1/2
+				muxes[i]->channels[j]->swapToFuture();//transmit private messages 1/2
 			}
 		}
 		for (ulong i = 0; i < partyCount; ++i) {
 			for (ulong j = 0; j <= i; ++j) {//all parties are waiting at this point, no need for locks
-				if (parties[i]->channels[j]->hasMsg()) {
-					parties[i]->channels[j]->recv()->printMsg(j);//print messages
+				for (auto const& m : muxes[i]->channels[j]->recvAll()) {
+					m->printMsg(j);//print messages
 				}
-				if (parties[j]->channels[i]->hasMsg() && (i != j)) {
-					parties[j]->channels[i]->recv()->printMsg(i);//print messages
+				if (i != j) {
+					for (auto const& m : muxes[j]->channels[i]->recvAll()) {
+						m->printMsg(i);//print messages
+					}
+					privateMessages += muxes[i]->channels[j]->recvAll().size() + muxes[j]->channels[i]->recvAll().size();
 				}
-				swap(parties[i]->channels[j], parties[j]->channels[i]);//transmit private messages 2/2
+				swap(muxes[i]->channels[j], muxes[j]->channels[i]);//transmit private messages 2/2
 			}
 			if (cb->hasMsg(i+1)) {
 				cb->recv(i+1)->printMsg();//print broadcast messages
+				broadcastMessages++;
 			}
 		}
+		for (ulong i = 0; i < partyCount; ++i) {
+			muxes[i]->unpack(cb);//received messages are routed to sessions
+		}
 #ifdef VERBOSE
 		const unsigned long R = 0;//print internal states of parties at the specified round
 		if (rounds == R) {
-			for (ulong i = 0; i < partyCount; ++i) {
-				stringstream ss;
-				parties[i]->print(ss);
-				cout << ss.str() << endl;
+			for (auto const& parties : sessions) {
+				for (ulong i = 0; i < partyCount; ++i) {
+					stringstream ss;
+					parties[i]->print(ss);
+					cout << ss.str() << endl;
+				}
 			}
 		}
 #endif
@@ -117,11 +144,13 @@ void synchronizer(Party** parties, ulong partyCount, ConsensusBroadcast* cb) {
 		const chrono::milliseconds ROUND_LENGTH(0);//Simulated communication takes place 'instantly' if set to 0.
 		this_thread::sleep_for(ROUND_LENGTH);
 		//Synchronizer signals 'messagesReady'
-		for (ulong i = 0; i < partyCount; ++i) {
-			lock_guard<mutex> lk(parties[i]->m);
-			if (!parties[i]->done) {
-				parties[i]->messagesReady = true;
-				parties[i]->cv.notify_one();
+		for (auto const& parties : sessions) {
+			for (ulong i = 0; i < partyCount; ++i) {
+				lock_guard<mutex> lk(parties[i]->m);
+				if (!parties[i]->done) {
+					parties[i]->messagesReady = true;
+					parties[i]->cv.notify_one();
+				}
 			}
 		}
 	}
@@ -149,75 +178,165 @@ int main() {
 	 * The data user will combine the shares to obtain the result and output it to the console.
 	 * See 'Party::setDataUser'
 	 */
-	Party** computingParties;
+	vector<Party**> sessions;//sessions[0] evaluates the main circuit, the others evaluate the circuits of the concurrent sessions
+	const ulong SESSION_COUNT = 1 + sopt.sessionCircuitDescStrings.size();
 
 	//Setup
-	computingParties = new Party*[sopt.N];
-	thread* computingThreads = new thread[sopt.N]; // Each computing party will run on its own thread.
-	ConsensusBroadcast* cb = new ConsensusBroadcast();
+	SessionMultiplexer** muxes = new SessionMultiplexer*[sopt.N];
 	for (ulong i = 0; i < sopt.N; ++i) {
-		PartyId id = i+1;
-		computingParties[i] = new Party(id, sopt.N, sopt.T, sopt.FIELD_PRIME);
-		Circuit* testCircuit;
-		if (sopt.comparator) {
-			testCircuit = cg.generateComparator(sopt.bitlength, sopt.labelA, sopt.labelB, sopt.labelOne);
-		} else {
-			testCircuit = cg.generate(sopt.circuitDescString);
-		}
-		computingParties[i]->setCircuit(testCircuit);
-		computingParties[i]->setProtocol(sopt.prot);
-		//set consensus broadcast channel
-		computingParties[i]->setBroadcast(cb);
-		//create and set secure P2P channels between computing parties
-		for (ulong j = 0; j < sopt.N; ++j) {
-			computingParties[i]->setChannelTo(j, new SecureChannel());
-		}
-		//set data user
-		computingParties[i]->setDataUser(sopt.dataUser);
-	}
-	//For the data providers, set the labels and values of secrets to be input.
-	for (SimulatorOptions::Input& s : sopt.secrets) {
-		computingParties[s.p-1]->addSecret(s.label, s.value);
+		muxes[i] = new SessionMultiplexer(i+1, sopt.N, sopt.FIELD_PRIME);
 	}
-	//set dishonest parties [makes sense only for PCEAS]
-	for (auto const& s : sopt.activelyCorrupted) {
-		computingParties[s-1]->setDishonest();
+	vector<ConsensusBroadcast*> sessionBroadcasts;
+	auto generateCircuit = [&sopt, &cg](ulong s) {//circuit of session s
+		if (s > 0) {
+			return cg.generate(sopt.sessionCircuitDescStrings[s-1]);
+		} else if (sopt.comparator) {
+			return cg.generateComparator(sopt.bitlength, sopt.labelA, sopt.labelB, sopt.labelOne);
+		}
+		return cg.generate(sopt.circuitDescString);
+	};
+	for (ulong s = 0; s < SESSION_COUNT; ++s) {
+		Party** computingParties = new Party*[sopt.N];
+		ConsensusBroadcast* scb = new ConsensusBroadcast();
+		unordered_set<string> labels;//input labels of the session's circuit
+		for (ulong i = 0; i < sopt.N; ++i) {
+			PartyId id = i+1;
+			computingParties[i] = new Party(id, sopt.N, sopt.T, sopt.FIELD_PRIME);
+			Circuit* testCircuit = generateCircuit(s);
+			computingParties[i]->setCircuit(testCircuit);
+			labels = testCircuit->getLabels();
+			if (sopt.prot == PCEPS_WITH_ABORT) {//a copy of the circuit, to be evaluated on randomized values
+				computingParties[i]->setRandomizedCircuit(generateCircuit(s));
+			}
+			if (s == 0 && sopt.batchRows > 0) {//batch evaluation : a copy of the circuit for each row of a chunk
+				const ulong chunkRows = (sopt.batchChunkRows == 0) ? sopt.batchRows : min(sopt.batchChunkRows, sopt.batchRows);
+				vector<Circuit*> batchCircuits;
+				for (ulong r = 0; r < chunkRows; ++r) {
+					batchCircuits.push_back(generateCircuit(0));
+				}
+				computingParties[i]->setBatchEvaluation(batchCircuits, sopt.batchRows, sopt.batchOutputPath);
+			}
+			computingParties[i]->setProtocol(sopt.prot);
+			computingParties[i]->setOnDemandMirroring(sopt.onDemandMirroring);
+			if (s == 0 && !sopt.statisticsFilePrefix.empty()) {
+				computingParties[i]->setStatisticsFile(sopt.statisticsFilePrefix + to_string(id) + ".csv");
+			}
+			if (s == 0 && !sopt.tripleStockpilePrefix.empty()) {//(triples must not be used in more than one session)
+				computingParties[i]->setTripleStockpile(sopt.tripleStockpilePrefix + to_string(id) + ".triples", sopt.offlineTripleCount);
+			}
+			computingParties[i]->setBatchedVerification(sopt.batchedVerificationSecurity);
+			computingParties[i]->setRobustOutputReconstruction(sopt.robustOutputReconstruction);
+			computingParties[i]->setOptimisticCommitments(sopt.optimisticCommitments);
+			computingParties[i]->setCepsBeaverTriples(sopt.cepsBeaverTriples);
+			computingParties[i]->setKingDegreeReduction(sopt.kingDegreeReduction);
+			computingParties[i]->setPackedInstances(sopt.packedInstances);
+			//set consensus broadcast channel (of the session)
+			computingParties[i]->setBroadcast(scb);
+			//create and set secure P2P channels between computing parties (of the session)
+			for (ulong j = 0; j < sopt.N; ++j) {
+				computingParties[i]->setChannelTo(j, new SecureChannel());
+			}
+			computingParties[i]->setSession(muxes[i]->addSession(computingParties[i]->channels, scb));
+			//set data user
+			computingParties[i]->setDataUser(sopt.dataUser);
+		}
+		//For the data providers, set the labels and values of secrets to be input.
+		for (SimulatorOptions::Input& in : sopt.batchSecrets) {//a column of the provider's CSV file
+			if (s == 0) {
+				computingParties[in.p-1]->addInstanceSecret(in.label, in.values);
+			}
+		}
+		for (SimulatorOptions::Input& in : sopt.secrets) {
+			if (s == 0 && sopt.batchRows > 0) {
+				break;//'#Inputs' are ignored in batch evaluation
+			} else if (s > 0 && labels.count(in.label) == 0) {
+				continue;//a concurrent session takes only the inputs its circuit uses
+			} else if (sopt.packedInstances > 1) {
+				computingParties[in.p-1]->addInstanceSecret(in.label, in.values);
+			} else {
+				computingParties[in.p-1]->addSecret(in.label, in.value);
+			}
+		}
+		if (s == 0) {
+			for (auto const& u : sopt.inputUpdates) {
+				computingParties[u.p-1]->addSecretUpdate(u.label, u.value);
+			}
+		}
+		//set dishonest parties [makes sense only for PCEAS and PCEPS_WITH_ABORT]
+		for (auto const& c : sopt.activelyCorrupted) {
+			computingParties[c-1]->setDishonest();
+		}
+		sessions.push_back(computingParties);
+		sessionBroadcasts.push_back(scb);
 	}
 
 	//Start secure evaluation
-	thread sync(synchronizer, computingParties, sopt.N, cb);
-	for (ulong i = 0; i < sopt.N; ++i) {
-		switch (sopt.prot) {
-			case PCEPS:
-			case PCEAS_WITH_CIRCUIT_RANDOMIZATION:
-				computingThreads[i] = thread(&Party::runProtocol, computingParties[i]);
-				break;
-			case PCEAS:
-				if (sopt.sequentialRun) {
-					Circuit* nextCircuit = cg.generate(sopt.nextRunCircuitDescString);
-					//note : To keep thing simple, we do next run with same secrets used for prev run (So we could skip input sharing phase for second run. But we don't.)
-					computingThreads[i] = thread(&Party::runProtocolSequential, computingParties[i], sopt.labelPrevRunResult, nextCircuit);
-				} else {
-					computingThreads[i] = thread(&Party::runProtocol, computingParties[i]);
-				}
-				break;
-			default:
-				computingThreads[i] = thread(&Party::runDummyInteractiveProtocol, computingParties[i], i+1);
-				break;
+	ConsensusBroadcast* cb = new ConsensusBroadcast();//shared by all sessions
+	thread sync(synchronizer, sessions, muxes, sopt.N, cb);
+	vector<thread> computingThreads; // Each computing party will run each session on its own thread.
+	for (ulong s = 0; s < SESSION_COUNT; ++s) {
+		Party** computingParties = sessions[s];
+		for (ulong i = 0; i < sopt.N; ++i) {
+			if (s > 0) {//concurrent sessions evaluate their circuits once
+				computingThreads.push_back(thread(&Party::runProtocol, computingParties[i]));
+				continue;
+			}
+			switch (sopt.prot) {
+				case PCEPS:
+				case PCEPS_WITH_ABORT:
+					computingThreads.push_back(thread(&Party::runProtocol, computingParties[i]));
+					break;
+				case PCEAS:
+				case PCEAS_WITH_CIRCUIT_RANDOMIZATION:
+					if (sopt.sequentialRun && sopt.offlineTripleCount == 0) {
+						//inputs are shared once, in the first run. Following runs use the inputs and the results of previous runs.
+						vector<Circuit*> nextCircuits;
+						for (auto const& desc : sopt.nextRunCircuitDescStrings) {
+							nextCircuits.push_back(cg.generate(desc));
+						}
+						computingThreads.push_back(thread(&Party::runProtocolSequential, computingParties[i], sopt.labelsPrevRunResult, nextCircuits));
+					} else if (!sopt.inputUpdates.empty() && sopt.offlineTripleCount == 0) {
+						//circuit is evaluated again after the updates, recomputing only the gates depending on updated inputs
+						computingThreads.push_back(thread(&Party::runProtocolIncremental, computingParties[i]));
+					} else {
+						computingThreads.push_back(thread(&Party::runProtocol, computingParties[i]));
+					}
+					break;
+				default:
+					computingThreads.push_back(thread(&Party::runDummyInteractiveProtocol, computingParties[i], i+1));
+					break;
+			}
 		}
 	}
 	sync.join();
-	for (ulong i = 0; i < sopt.N; ++i) {
-		computingThreads[i].join();
+	for (auto& t : computingThreads) {
+		t.join();
+	}
+	//report parties the data user found to send incorrect output shares (robust output reconstruction)
+	for (ulong s = 0; s < SESSION_COUNT; ++s) {
+		unordered_set<PartyId> const& cheaters = sessions[s][sopt.dataUser-1]->getOutputCheaters();
+		if (!cheaters.empty()) {
+			cout << "Incorrect output shares" << ((s == 0) ? "" : " (session " + to_string(s) + ")") << " from : ";
+			for (auto const& p : cheaters) {
+				cout << to_string(p) << "\t";
+			}
+			cout << endl;
+		}
 	}
 
 	//Cleanup
+	for (ulong s = 0; s < SESSION_COUNT; ++s) {
+		for (ulong i = 0; i < sopt.N; ++i) {
+			delete sessions[s][i];
+		}
+		delete[] sessions[s];
+		delete sessionBroadcasts[s];
+	}
 	for (ulong i = 0; i < sopt.N; ++i) {
-		delete computingParties[i];
+		delete muxes[i];
 	}
+	delete[] muxes;
 	delete cb;
-	delete[] computingParties;
-	delete[] computingThreads;
 
 	cout << "End " << endl;
 
@@ -50,8 +50,24 @@ public:
 		comparator = false;
 		circuitDescString = "";
 		sequentialRun = false;
+		onDemandMirroring = false;
+		statisticsFilePrefix = "";
+		tripleStockpilePrefix = "";
+		offlineTripleCount = 0;
+		batchedVerificationSecurity = 0;
+		robustOutputReconstruction = false;
+		optimisticCommitments = false;
+		cepsBeaverTriples = false;
+		kingDegreeReduction = false;
+		packedInstances = 1;
+		batchRows = 0;
+		batchOutputPath = "";
+		batchChunkRows = 0;
 
 		loadOptionsFromFile();
+		if (batchRows > 0 && batchOutputPath.empty()) {
+			throw runtime_error("No batch output file.");
+		}
 	}
 	virtual ~SimulatorOptions() {}
 
@@ -59,6 +75,7 @@ public:
 		PartyId p;
 		string label;
 		ulong value;
+		vector<ulong> values;//value for each instance, for packed evaluation (first one is 'value')
 	};
 
 	ulong N;//Number of computing parties
@@ -91,8 +108,84 @@ public:
 	string circuitDescString;
 
 	bool sequentialRun;
-	string labelPrevRunResult;
-	string nextRunCircuitDescString;
+	vector<string> labelsPrevRunResult;//label of the result of each run, except the last one
+	vector<string> nextRunCircuitDescStrings;//circuit of each run after the first one
+
+	/*
+	 * PCEAS only : records for other parties' shares of gate outputs
+	 * are derived only when they are needed.
+	 */
+	bool onDemandMirroring;
+
+	/*
+	 * PCEAS only : if not empty, each party writes commitment table statistics
+	 * (CSV, one line per phase and per gate) to <statisticsFilePrefix><partyID>.csv
+	 */
+	string statisticsFilePrefix;
+
+	/*
+	 * PCEAS_WITH_CIRCUIT_RANDOMIZATION only : if not empty, each party keeps a stockpile of
+	 * multiplication triples in <tripleStockpilePrefix><partyID>.triples
+	 * If 'offlineTripleCount' > 0, only preprocessing is run (offline mode), and that many triples are saved.
+	 * Otherwise, triples are taken from the stockpile, and preprocessing is skipped.
+	 */
+	string tripleStockpilePrefix;
+	ulong offlineTripleCount;
+
+	/*
+	 * PCEAS only : if > 0, verifiers of opened commitments are checked together via random linear combinations,
+	 * with error probability at most 2^-batchedVerificationSecurity
+	 */
+	ulong batchedVerificationSecurity;
+
+	/*
+	 * PCEAS only : if true, output shares are sent to the data user without verification,
+	 * and the data user recovers the output by Reed-Solomon decoding
+	 */
+	bool robustOutputReconstruction;
+
+	/*
+	 * PCEAS only : if true, commitments end after the first consensus broadcast, if nobody disputes
+	 */
+	bool optimisticCommitments;
+
+	/*
+	 * PCEPS only : if true, multiplications use Beaver triples generated in a preprocessing phase
+	 */
+	bool cepsBeaverTriples;
+
+	/*
+	 * PCEPS only : if true, degree reduction goes through a king (using preprocessed double sharings) instead of resharing
+	 */
+	bool kingDegreeReduction;
+
+	/*
+	 * PCEPS only : number of instances of the circuit evaluated in a single run with packed secret sharing
+	 * (each input must then have a value for each instance)
+	 */
+	ulong packedInstances;
+
+	/*
+	 * PCEPS only : batch evaluation over rows read from a CSV file for each data provider.
+	 * batchSecrets holds a column (a value for each row) for each input label.
+	 * Results are written to batchOutputPath, after each chunk of batchChunkRows rows (0 : all rows in a single chunk).
+	 */
+	vector<Input> batchSecrets;
+	ulong batchRows;
+	string batchOutputPath;
+	ulong batchChunkRows;
+
+	/*
+	 * PCEAS only : after the first evaluation, these inputs get new values and the circuit is evaluated again,
+	 * recomputing only the gates which depend on them
+	 */
+	vector<Input> inputUpdates;
+
+	/*
+	 * Circuits of the concurrent sessions : each is evaluated on the same inputs in its own session, interleaved with
+	 * the main evaluation in the same rounds (see 'SessionMultiplexer')
+	 */
+	vector<string> sessionCircuitDescStrings;
 
 private:
 	const string OPTIONS_FILE_PATH = "./options/opt";
@@ -111,6 +204,19 @@ private:
 		COMPARATOR_,
 		CIRCUIT_DESC_,
 		SEQ_RUN_,
+		ON_DEMAND_MIRRORING_,
+		STATISTICS_,
+		TRIPLE_STOCKPILE_,
+		BATCHED_VERIFICATION_,
+		ROBUST_OUTPUT_,
+		OPTIMISTIC_COMMIT_,
+		CEPS_BEAVER_,
+		CEPS_DEGREE_REDUCTION_,
+		PACKED_INSTANCES_,
+		BATCH_INPUTS_,
+		BATCH_OUTPUT_,
+		INCREMENTAL_UPDATE_,
+		CONCURRENT_SESSIONS_,
 		FINISH_
 	};
 
@@ -147,6 +253,45 @@ private:
 			return SEQ_RUN_;
 			break;
 		case SEQ_RUN_:
+			return ON_DEMAND_MIRRORING_;
+			break;
+		case ON_DEMAND_MIRRORING_:
+			return STATISTICS_;
+			break;
+		case STATISTICS_:
+			return TRIPLE_STOCKPILE_;
+			break;
+		case TRIPLE_STOCKPILE_:
+			return BATCHED_VERIFICATION_;
+			break;
+		case BATCHED_VERIFICATION_:
+			return ROBUST_OUTPUT_;
+			break;
+		case ROBUST_OUTPUT_:
+			return OPTIMISTIC_COMMIT_;
+			break;
+		case OPTIMISTIC_COMMIT_:
+			return CEPS_BEAVER_;
+			break;
+		case CEPS_BEAVER_:
+			return CEPS_DEGREE_REDUCTION_;
+			break;
+		case CEPS_DEGREE_REDUCTION_:
+			return PACKED_INSTANCES_;
+			break;
+		case PACKED_INSTANCES_:
+			return BATCH_INPUTS_;
+			break;
+		case BATCH_INPUTS_:
+			return BATCH_OUTPUT_;
+			break;
+		case BATCH_OUTPUT_:
+			return INCREMENTAL_UPDATE_;
+			break;
+		case INCREMENTAL_UPDATE_:
+			return CONCURRENT_SESSIONS_;
+			break;
+		case CONCURRENT_SESSIONS_:
 			return FINISH_;
 			break;
 		default:
@@ -193,6 +338,10 @@ private:
 				    	in.p = atol((*it).c_str());
 				    	in.label = *++it;
 				    	in.value = atol((*++it).c_str());
+				    	in.values.push_back(in.value);
+				    	while (++it != tokens.end()) {//values for other instances (packed evaluation)
+				    		in.values.push_back(atol((*it).c_str()));
+				    	}
 				    	secrets.push_back(in);
 				    	break;
 				    }
@@ -230,12 +379,125 @@ private:
 					    	string seq = *it;
 					    	boost::to_upper(seq);
 					    	sequentialRun = (seq == TRUE);
-					    	if (sequentialRun) {
-					    		labelPrevRunResult = *++it;
-					    		nextRunCircuitDescString = *++it;
+					    	while (sequentialRun && ++it != tokens.end()) {//any number of (label, circuit) pairs
+					    		labelsPrevRunResult.push_back(*it);
+					    		if (++it == tokens.end()) {
+					    			throw runtime_error("Bad options file.");
+					    		}
+					    		nextRunCircuitDescStrings.push_back(*it);
 					    	}
 				    	}
 				    	break;
+				    case ON_DEMAND_MIRRORING_:
+				    	if (it != tokens.end()) {
+				    		const string TRUE = "TRUE";
+				    		string onDemand = *it;
+				    		boost::to_upper(onDemand);
+				    		onDemandMirroring = (onDemand == TRUE);
+				    	}
+				    	break;
+				    case STATISTICS_:
+				    	if (it != tokens.end()) {
+				    		statisticsFilePrefix = *it;
+				    	}
+				    	break;
+				    case TRIPLE_STOCKPILE_:
+				    	if (it != tokens.end()) {
+				    		tripleStockpilePrefix = *it;
+				    		if (++it != tokens.end()) {
+				    			offlineTripleCount = atol((*it).c_str());
+				    		}
+				    	}
+				    	break;
+				    case BATCHED_VERIFICATION_:
+				    	if (it != tokens.end()) {
+				    		batchedVerificationSecurity = atol((*it).c_str());
+				    	}
+				    	break;
+				    case ROBUST_OUTPUT_:
+				    	if (it != tokens.end()) {
+				    		const string TRUE = "TRUE";
+				    		string robust = *it;
+				    		boost::to_upper(robust);
+				    		robustOutputReconstruction = (robust == TRUE);
+				    	}
+				    	break;
+				    case OPTIMISTIC_COMMIT_:
+				    	if (it != tokens.end()) {
+				    		const string TRUE = "TRUE";
+				    		string optimistic = *it;
+				    		boost::to_upper(optimistic);
+				    		optimisticCommitments = (optimistic == TRUE);
+				    	}
+				    	break;
+				    case CEPS_BEAVER_:
+				    	if (it != tokens.end()) {
+				    		const string TRUE = "TRUE";
+				    		string beaver = *it;
+				    		boost::to_upper(beaver);
+				    		cepsBeaverTriples = (beaver == TRUE);
+				    	}
+				    	break;
+				    case CEPS_DEGREE_REDUCTION_:
+				    	if (it != tokens.end()) {
+				    		const string KING = "KING";
+				    		const string RESHARING = "RESHARING";
+				    		string strategy = *it;
+				    		boost::to_upper(strategy);
+				    		if (strategy == KING) {
+				    			kingDegreeReduction = true;
+				    		} else if (strategy == RESHARING) {
+				    			kingDegreeReduction = false;
+				    		} else {
+				    			throw runtime_error("Bad options file.");
+				    		}
+				    	}
+				    	break;
+				    case PACKED_INSTANCES_:
+				    	if (it != tokens.end()) {
+				    		packedInstances = atol((*it).c_str());
+				    		if (packedInstances == 0) {
+				    			throw runtime_error("Bad options file.");
+				    		}
+				    	}
+				    	break;
+				    case BATCH_INPUTS_:
+				    	if (it != tokens.end()) {
+				    		PartyId p = atol((*it).c_str());
+				    		if (++it == tokens.end()) {
+				    			throw runtime_error("Bad options file.");
+				    		}
+				    		loadBatchInputs(p, *it);
+				    	}
+				    	break;
+				    case BATCH_OUTPUT_:
+				    	if (it != tokens.end()) {
+				    		batchOutputPath = *it;
+				    		if (++it != tokens.end()) {
+				    			batchChunkRows = atol((*it).c_str());
+				    		}
+				    	}
+				    	break;
+				    case INCREMENTAL_UPDATE_:
+				    	if (it != tokens.end()) {
+				    		Input in;
+				    		in.p = atol((*it).c_str());
+				    		if (++it == tokens.end()) {
+				    			throw runtime_error("Bad options file.");
+				    		}
+				    		in.label = *it;
+				    		if (++it == tokens.end()) {
+				    			throw runtime_error("Bad options file.");
+				    		}
+				    		in.value = atol((*it).c_str());
+				    		inputUpdates.push_back(in);
+				    	}
+				    	break;
+				    case CONCURRENT_SESSIONS_:
+				    	if (it != tokens.end()) {
+				    		sessionCircuitDescStrings.push_back(*it);
+				    	}
+				    	break;
 				    default:
 				    	throw runtime_error("Bad options file.");
 				    	break;
@@ -247,6 +509,57 @@ private:
 			throw runtime_error("Could not open options file.");
 		}
 	}
+
+	/*
+	 * Reads the input rows of data provider 'p' from a CSV file : the first line holds the labels,
+	 * each following line holds a value for each label.
+	 */
+	void loadBatchInputs(PartyId p, string path) {
+		ifstream infile(path);
+		if (!infile.is_open()) {
+			throw runtime_error("Could not open batch input file : " + path);
+		}
+		boost::char_separator<char> sep(",");
+		string line;
+		vector<Input> columns;
+		ulong rows = 0;
+		while (getline(infile, line)) {
+		    boost::algorithm::erase_all(line, " ");
+		    boost::algorithm::erase_all(line, "\t");
+		    boost::algorithm::erase_all(line, "\r");
+		    if (line.empty()) {
+		    	continue;
+		    }
+		    boost::tokenizer<boost::char_separator<char>> tokens(line, sep);
+		    vector<string> fields(tokens.begin(), tokens.end());
+		    if (columns.empty()) {//header
+		    	for (auto const& label : fields) {
+		    		Input in;
+		    		in.p = p;
+		    		in.label = label;
+		    		in.value = 0;
+		    		columns.push_back(in);
+		    	}
+		    	continue;
+		    }
+		    if (fields.size() != columns.size()) {
+		    	throw runtime_error("Bad batch input file : " + path);
+		    }
+		    for (ulong i = 0; i < fields.size(); ++i) {
+		    	columns[i].values.push_back(atol(fields[i].c_str()));
+		    }
+		    rows++;
+		}
+		infile.close();
+		if (rows == 0 || (batchRows != 0 && rows != batchRows)) {//all providers must have the same number of rows
+			throw runtime_error("Bad batch input file : " + path);
+		}
+		batchRows = rows;
+		for (auto& in : columns) {
+			in.value = in.values.front();
+			batchSecrets.push_back(in);
+		}
+	}
 };
 
 } /* namespace pceas */
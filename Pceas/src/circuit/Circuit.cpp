@@ -53,10 +53,60 @@ Gate* Circuit::getNext() {
 	return nullptr;
 }
 
+/**
+ * Returns all gates of type 'type', which have not been computed yet, but are computable.
+ * None of these gates depends on another, so they can be computed in parallel.
+ */
+vector<Gate*> Circuit::getReady(GateType type) {
+	vector<Gate*> ready;
+	for (auto& g : gates) {
+		if (g->getType() == type && !g->isProcessed() && g->isReady()) {
+			ready.push_back(g);
+		}
+	}
+	return ready;
+}
+
 void Circuit::addGate(Gate* g) {
 	gates.push_back(g);
 }
 
+/**
+ * Unassigns all wires, so that the circuit can be evaluated again (with new inputs)
+ */
+void Circuit::reset() {
+	for (auto& g : gates) {
+		g->reset();
+	}
+}
+
+/**
+ * Incremental evaluation : input wires labelled with any of 'labels' are unassigned, together with the results of
+ * all gates depending on them (the fan-out cone). Results of other gates are kept.
+ * The output gate is always included, so that the output is delivered again.
+ * Returns the gates to be recomputed.
+ */
+vector<Gate*> Circuit::markDirty(unordered_set<string> const& labels) {
+	for (auto& g : gates) {
+		for (auto const& label : labels) {
+			g->unassignInput(label);
+		}
+	}
+	vector<Gate*> dirty;
+	bool changed = true;
+	while (changed) {//until no stale input reaches a processed gate
+		changed = false;
+		for (auto& g : gates) {
+			if (g->isProcessed() && (!g->isReady() || g->isOutputGate())) {
+				g->unassignResult();
+				dirty.push_back(g);
+				changed = true;
+			}
+		}
+	}
+	return dirty;
+}
+
 void Circuit::sortGates() {
 	sort(gates.begin(), gates.end(), [](Gate* g1, Gate* g2){return g1->getGateNumber() < g2->getGateNumber();});
 }
@@ -41,7 +41,10 @@ public:
 	virtual ~Circuit();
 
 	Gate* getNext();
+	vector<Gate*> getReady(GateType type);
 	void sortGates();
+	void reset();
+	vector<Gate*> markDirty(unordered_set<string> const& labels);
 	unsigned long getInputCount() const;
 	unordered_set<string> getLabels() const;
 	unsigned long getOutputCount() const;
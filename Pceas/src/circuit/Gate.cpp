@@ -84,6 +84,39 @@ void Gate::assignResult(CommitmentId const& result) {
 	}
 }
 
+void Gate::reset() {
+	for (auto& w : inputs) {
+		w->unassign();
+	}
+	for (auto& w : outputs) {
+		w->unassign();
+	}
+}
+
+void Gate::unassignResult() {
+	for (auto& w : outputs) {
+		w->unassign();
+		if (w->getNext() != nullptr) {
+			for (auto& iw : w->getNext()->inputs) {
+				if (iw->getPrev() == this) {
+					iw->unassign();
+				}
+			}
+		}
+	}
+}
+
+bool Gate::unassignInput(std::string label) {
+	bool unassigned = false;
+	for (auto& w : inputs) {
+		if (w->getPrev() == nullptr && w->getInputLabel() == label) {
+			w->unassign();
+			unassigned = true;//continue, label might occur multiple times
+		}
+	}
+	return unassigned;
+}
+
 bool Gate::assignInput(fmpz_t const& val, std::string label) {
 	bool assigned = false;
 	for (auto& w : inputs) {
@@ -66,9 +66,19 @@ public:
 	 * Result is assigned to output wires, and input wires of following gates
 	 */
 	void assignResult(CommitmentId const& result);
+	/**
+	 * Output wires, and input wires of following gates, are unassigned (result becomes stale)
+	 */
+	void unassignResult();
+
+	/**
+	 * All input and output wires are unassigned, so that the gate can be computed again
+	 */
+	void reset();
 
 	bool assignInput(fmpz_t const& val, std::string label);
 	bool assignInput(CommitmentId const& cid, std::string label);
+	bool unassignInput(std::string label);
 
 	fmpz_t& getLocalResult() {
 		return localResult;
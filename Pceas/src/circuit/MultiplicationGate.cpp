@@ -46,4 +46,12 @@ CommitmentId MultiplicationGate::getInputCid2() const {
 	return inputs.at(1)->getCid();
 }
 
+fmpz_t const& MultiplicationGate::getInputValue1() const {
+	return inputs.at(0)->getValue();
+}
+
+fmpz_t const& MultiplicationGate::getInputValue2() const {
+	return inputs.at(1)->getValue();
+}
+
 } /* namespace pceas */
@@ -42,6 +42,8 @@ public:
 	void localCompute();
 	CommitmentId getInputCid1() const;
 	CommitmentId getInputCid2() const;
+	fmpz_t const& getInputValue1() const;
+	fmpz_t const& getInputValue2() const;
 };
 
 } /* namespace pceas */
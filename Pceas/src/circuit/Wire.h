@@ -82,6 +82,10 @@ public:
 		assigned = true;
 	}
 
+	void unassign() {
+		assigned = false;
+	}
+
 	const std::string& getInputLabel() const {
 		return inputLabel;
 	}
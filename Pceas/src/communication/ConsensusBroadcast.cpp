@@ -63,4 +63,29 @@ void ConsensusBroadcast::swapToFuture() {
 	swap(messages, future);
 }
 
+/**
+ * Called by session multiplexer : takes the message broadcast by 'sender' in this round (nullptr if none)
+ */
+MessagePtr ConsensusBroadcast::collect(PartyId sender) {
+	lock_guard<mutex> guard(mut);
+	auto it = future.find(sender);
+	if (it == future.end()) {
+		return nullptr;
+	}
+	MessagePtr m = it->second;
+	future.erase(it);
+	return m;
+}
+
+/**
+ * Called by session multiplexer : replaces the past message of 'sender' with the one received in this round (nullptr if none)
+ */
+void ConsensusBroadcast::deliver(PartyId sender, MessagePtr m) {
+	lock_guard<mutex> guard(mut);
+	messages.erase(sender);
+	if (m != nullptr) {
+		messages.insert(pair<PartyId,MessagePtr>(sender,m));
+	}
+}
+
 } /* namespace pceas */
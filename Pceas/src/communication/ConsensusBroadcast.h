@@ -45,6 +45,8 @@ public:
 	MessagePtr recv(PartyId sender);
 	bool hasMsg(PartyId sender);
 	void swapToFuture();
+	MessagePtr collect(PartyId sender);
+	void deliver(PartyId sender, MessagePtr m);
 private:
 	unordered_map<PartyId, MessagePtr> messages;
 	unordered_map<PartyId, MessagePtr> future;
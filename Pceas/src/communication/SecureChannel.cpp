@@ -35,27 +35,57 @@ SecureChannel::SecureChannel() {
 SecureChannel::~SecureChannel() {
 }
 
+/**
+ * Messages are queued, any number of messages can be sent over the channel in a single round.
+ */
 void SecureChannel::send(MessagePtr m) {
-	future = m;
+	futures.push_back(m);
 }
 
+/**
+ * Returns the first message received in the last round.
+ */
 MessagePtr SecureChannel::recv() {
-	if (message == nullptr) {
+	if (messages.empty()) {
 		throw PceasException("No message.");
 	}
-	return message;
+	return messages.front();
+}
+
+/**
+ * Returns all messages received in the last round, in order of sending.
+ */
+vector<MessagePtr> const& SecureChannel::recvAll() const {
+	return messages;
 }
 
 bool SecureChannel::hasMsg() const {
-	return message != nullptr;
+	return !messages.empty();
 }
 
 /**
  * Called by synchronizer
  */
 void SecureChannel::swapToFuture() {
-	message = nullptr;//discard past
-	swap(message, future);
+	messages.clear();//discard past
+	swap(messages, futures);
+}
+
+/**
+ * Called by session multiplexer : takes the messages sent over the channel in this round, and discards past
+ */
+vector<MessagePtr> SecureChannel::collect() {
+	messages.clear();
+	vector<MessagePtr> sent;
+	swap(sent, futures);
+	return sent;
+}
+
+/**
+ * Called by session multiplexer : delivers a message received in this round
+ */
+void SecureChannel::deliver(MessagePtr m) {
+	messages.push_back(m);
 }
 
 } /* namespace pceas */
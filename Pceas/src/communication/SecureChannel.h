@@ -42,11 +42,14 @@ public:
 
 	void send(MessagePtr m);
 	MessagePtr recv();
+	vector<MessagePtr> const& recvAll() const;
 	bool hasMsg() const;
 	void swapToFuture();
+	vector<MessagePtr> collect();
+	void deliver(MessagePtr m);
 private:
-	MessagePtr message;
-	MessagePtr future;
+	vector<MessagePtr> messages;//all messages sent over the channel in the last round, in order of sending
+	vector<MessagePtr> futures;
 };
 
 } /* namespace pceas */
@@ -0,0 +1,136 @@
+/**************************************************************************************
+**
+** Copyright (C) 2017 Mert Dönmez
+**
+** This file is part of PCEAS
+**
+** PCEAS is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** PCEAS is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with PCEAS.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************************/
+/*
+ * SessionMultiplexer.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: m3r7
+ */
+
+#include "SessionMultiplexer.h"
+
+namespace pceas {
+
+SessionMultiplexer::SessionMultiplexer(PartyId pid, ulong partyCount, ulong fieldPrime) : pid(pid), N(partyCount) {
+	fmpz_init(FIELD_PRIME);
+	fmpz_set_ui(FIELD_PRIME, fieldPrime);
+	channels = new SecureChannel*[N];
+	for (ulong i = 0; i < N; ++i) {
+		channels[i] = new SecureChannel();
+	}
+}
+
+SessionMultiplexer::~SessionMultiplexer() {
+	for (ulong i = 0; i < N; ++i) {
+		delete channels[i];
+	}
+	delete[] channels;
+	fmpz_clear(FIELD_PRIME);
+}
+
+/**
+ * Session channels and broadcast are owned by the caller. Returns the session ID, which the party
+ * running the session is expected to tag its messages with.
+ */
+SessionId SessionMultiplexer::addSession(SecureChannel** sessionChannels, ConsensusBroadcast* sessionBroadcast) {
+	Session s;
+	s.channels = sessionChannels;
+	s.broadcast = sessionBroadcast;
+	sessions.push_back(s);
+	return sessions.size() - 1;
+}
+
+/**
+ * Called by synchronizer (before transmission) : messages sent in all sessions this round are moved to the shared channels.
+ * With a single session, messages are moved as they are.
+ */
+void SessionMultiplexer::pack(ConsensusBroadcast* cb) {
+	for (ulong j = 0; j < N; ++j) {
+		vector<MessagePtr> sent;
+		for (auto const& s : sessions) {
+			for (auto const& m : s.channels[j]->collect()) {
+				sent.push_back(m);
+			}
+		}
+		if (sessions.size() == 1) {
+			for (auto const& m : sent) {
+				channels[j]->send(m);
+			}
+		} else if (!sent.empty()) {
+			channels[j]->send(newEnvelope(sent));
+		}
+	}
+	vector<MessagePtr> broadcasts;
+	for (auto const& s : sessions) {
+		MessagePtr m = s.broadcast->collect(pid);
+		if (m != nullptr) {
+			broadcasts.push_back(m);
+		}
+	}
+	if (sessions.size() == 1 && !broadcasts.empty()) {
+		cb->broadcast(broadcasts.front());
+	} else if (!broadcasts.empty()) {
+		cb->broadcast(newEnvelope(broadcasts));
+	}
+}
+
+/**
+ * Called by synchronizer (after transmission) : messages received on the shared channels are routed to sessions by their tags.
+ * Our own broadcast is routed by us, on behalf of all receivers. Messages tagged with an unknown session are dropped.
+ */
+void SessionMultiplexer::unpack(ConsensusBroadcast* cb) {
+	for (ulong j = 0; j < N; ++j) {
+		for (auto const& received : channels[j]->recvAll()) {
+			for (auto const& m : open(received)) {
+				if (m->getSession() < sessions.size()) {
+					sessions[m->getSession()].channels[j]->deliver(m);
+				}
+			}
+		}
+	}
+	vector<MessagePtr> broadcasts(sessions.size(), nullptr);
+	if (cb->hasMsg(pid)) {
+		for (auto const& m : open(cb->recv(pid))) {
+			if (m->getSession() < sessions.size()) {
+				broadcasts[m->getSession()] = m;
+			}
+		}
+	}
+	for (ulong s = 0; s < sessions.size(); ++s) {
+		sessions[s].broadcast->deliver(pid, broadcasts[s]);
+	}
+}
+
+MessagePtr SessionMultiplexer::newEnvelope(vector<MessagePtr> const& messages) const {
+	MessagePtr envelope(new Message(pid, FIELD_PRIME));
+	for (auto const& m : messages) {
+		envelope->addBatchMessage(m);
+	}
+	return envelope;
+}
+
+vector<MessagePtr> SessionMultiplexer::open(MessagePtr envelope) const {
+	if (sessions.size() == 1) {
+		return {envelope};
+	}
+	return envelope->getBatchMessages();
+}
+
+} /* namespace pceas */
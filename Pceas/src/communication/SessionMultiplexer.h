@@ -0,0 +1,70 @@
+/**************************************************************************************
+**
+** Copyright (C) 2017 Mert Dönmez
+**
+** This file is part of PCEAS
+**
+** PCEAS is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** PCEAS is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with PCEAS.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************************/
+/*
+ * SessionMultiplexer.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: m3r7
+ */
+
+#ifndef SESSIONMULTIPLEXER_H_
+#define SESSIONMULTIPLEXER_H_
+
+#include <vector>
+#include "SecureChannel.h"
+#include "ConsensusBroadcast.h"
+
+namespace pceas {
+
+/**
+ * Multiplexes the protocol sessions run by a single party over the same secure channels and consensus broadcast,
+ * so that independent evaluations interleave in the same rounds.
+ *
+ * Each session is run by its own 'Party' (with its own circuit and commitment table), which sends session-tagged messages
+ * over session channels. Each round, messages sent in all sessions to the same party are packed into a single message
+ * (and all broadcasts into a single broadcast), and received messages are routed back to sessions by their tags.
+ * Hence the number of rounds is that of the longest session, not the sum over the sessions.
+ */
+class SessionMultiplexer {
+public:
+	SessionMultiplexer(PartyId pid, ulong partyCount, ulong fieldPrime);
+	virtual ~SessionMultiplexer();
+
+	SessionId addSession(SecureChannel** sessionChannels, ConsensusBroadcast* sessionBroadcast);
+	void pack(ConsensusBroadcast* cb);
+	void unpack(ConsensusBroadcast* cb);
+
+	SecureChannel** channels;//channels to other parties, shared by all sessions
+private:
+	struct Session {
+		SecureChannel** channels;
+		ConsensusBroadcast* broadcast;
+	};
+	const PartyId pid;
+	const ulong N;
+	fmpz_t FIELD_PRIME;
+	vector<Session> sessions;
+	MessagePtr newEnvelope(vector<MessagePtr> const& messages) const;
+	vector<MessagePtr> open(MessagePtr envelope) const;
+};
+
+} /* namespace pceas */
+
+#endif /* SESSIONMULTIPLEXER_H_ */
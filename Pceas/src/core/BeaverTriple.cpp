@@ -0,0 +1,43 @@
+/**************************************************************************************
+**
+** Copyright (C) 2017 Mert Dönmez
+**
+** This file is part of PCEAS
+**
+** PCEAS is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** PCEAS is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with PCEAS.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************************/
+/*
+ * BeaverTriple.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: m3r7
+ */
+
+#include "BeaverTriple.h"
+
+namespace pceas {
+
+BeaverTriple::BeaverTriple() {
+	fmpz_init(x);
+	fmpz_init(y);
+	fmpz_init(z);
+}
+
+BeaverTriple::~BeaverTriple() {
+	fmpz_clear(x);
+	fmpz_clear(y);
+	fmpz_clear(z);
+}
+
+} /* namespace pceas */
@@ -0,0 +1,52 @@
+/**************************************************************************************
+**
+** Copyright (C) 2017 Mert Dönmez
+**
+** This file is part of PCEAS
+**
+** PCEAS is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** PCEAS is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with PCEAS.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************************/
+/*
+ * BeaverTriple.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: m3r7
+ */
+
+#ifndef BEAVERTRIPLE_H_
+#define BEAVERTRIPLE_H_
+
+#include <fmpz.h>
+
+namespace pceas {
+
+/**
+ * Our Shamir shares [x], [y], [z] of a random multiplication triple (z = x * y).
+ * (Used by protocol 'CEPS'. For 'CEAS' see 'MultiplicationTriple')
+ */
+class BeaverTriple {
+public:
+	BeaverTriple();
+	virtual ~BeaverTriple();
+	BeaverTriple(BeaverTriple const&) = delete;
+	BeaverTriple& operator=(BeaverTriple const&) = delete;
+
+	fmpz_t x;
+	fmpz_t y;
+	fmpz_t z;
+};
+
+} /* namespace pceas */
+
+#endif /* BEAVERTRIPLE_H_ */
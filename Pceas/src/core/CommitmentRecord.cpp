@@ -29,34 +29,98 @@
 
 namespace pceas {
 
+const vector<DisputedValue> CommitmentRecord::NO_DISPUTES;
+const unordered_set<PartyId> CommitmentRecord::NO_ACCUSERS;
+const string CommitmentRecord::NO_NAME = NONE;
+
 CommitmentRecord::CommitmentRecord(PartyId owner, fmpz_t const& m, PartyId recordHolder):
-		owner(owner), recordHolder(recordHolder), verifiableShare(VerifiableShare(m)), broadcastVerifiableShare(VerifiableShare(m)), fx_0(VerifiableShare(m)) {
+		owner(owner), recordHolder(recordHolder) {
 	fmpz_init(mod);
 	fmpz_set(mod, m);
 	fmpz_init(share);
-	fmpz_init(openedValue);
 	inprogress = true;
 	success = false;
 	opened = false;
-	designatedOpened = false;
 	input = false;
-	inputLabel = NONE;
 	output = false;
 	vssFlag = false;
-	newVerifiableShareBroadcast = false;
-	inconsistentBroadcast = false;
 	permanent = false;
-	distributer = NOPARTY;
 	mulTriple = false;
+	lazy = false;
 }
 
 CommitmentRecord::~CommitmentRecord() {
+	materializeDependents();
+	releaseTerms();
 	fmpz_clear(mod);
 	fmpz_clear(share);
-	fmpz_clear(openedValue);
+}
+
+CommitmentRecord::OngoingState& CommitmentRecord::getOngoingState() {
+	if (!ongoing) {
+		ongoing.reset(new OngoingState(mod));
+	}
+	return *ongoing;
+}
+
+CommitmentRecord::ShareInfo& CommitmentRecord::getShareInfo() {
+	if (!shareInfo) {
+		shareInfo.reset(new ShareInfo());
+	}
+	return *shareInfo;
+}
+
+CommitmentRecord::OwnerState& CommitmentRecord::getOwnerState() {
+	if (!ownerState) {
+		ownerState.reset(new OwnerState(mod));
+	}
+	return *ownerState;
+}
+
+/**
+ * Verifiable shares, disputes and accusations are no longer needed once the commitment is done.
+ */
+void CommitmentRecord::releaseOngoingState() {
+	ongoing.reset();
+}
+
+/**
+ * Bytes allocated for coefficients of the polynomials held by this record
+ */
+size_t CommitmentRecord::getPolyBytes() const {
+	size_t bytes = 0;
+	if (ownerState) {
+		bytes += ownerState->fx_0->alloc * sizeof(fmpz);
+	}
+	if (ongoing) {
+		bytes += ongoing->verifiableShare.fkx->alloc * sizeof(fmpz);
+		bytes += ongoing->broadcastVerifiableShare.fkx->alloc * sizeof(fmpz);
+	}
+	return bytes;
+}
+
+/**
+ * Bytes allocated for this record, including its polynomials and terms (approximately, as the commitment ID is left out)
+ */
+size_t CommitmentRecord::getBytes() const {
+	size_t bytes = sizeof(CommitmentRecord) + getPolyBytes();
+	if (terms) {
+		bytes += sizeof(vector<LinearTerm>) + terms->capacity() * sizeof(LinearTerm);
+	}
+	if (shareInfo) {
+		bytes += sizeof(ShareInfo);
+	}
+	if (ongoing) {
+		bytes += sizeof(OngoingState) + ongoing->disputes.capacity() * sizeof(DisputedValue);
+	}
+	if (ownerState) {
+		bytes += sizeof(OwnerState);
+	}
+	return bytes;
 }
 
 void CommitmentRecord::addDispute(PartyId disputer, PartyId disputed) {
+	auto& disputes = getOngoingState().disputes;
 	for (auto const& dv : disputes) {
 		if (dv.disputer == disputer && dv.disputed == disputed) {//ignore duplicates
 			return;
@@ -69,7 +133,7 @@ void CommitmentRecord::addDispute(PartyId disputer, PartyId disputed) {
 }
 
 void CommitmentRecord::setDisputeValue(PartyId disputer, PartyId disputed, fmpz_t const& val) {
-	for (auto& dv : disputes) {
+	for (auto& dv : getOngoingState().disputes) {
 		if (dv.disputer == disputer && dv.disputed == disputed) {
 			fmpz_set(dv.val, val);
 			dv.opened = true;
@@ -79,14 +143,15 @@ void CommitmentRecord::setDisputeValue(PartyId disputer, PartyId disputed, fmpz_
 }
 
 void CommitmentRecord::addAccuser(PartyId accuser) {
-	accusers.insert(accuser);
+	getOngoingState().accusers.insert(accuser);
 }
 
 PartyId CommitmentRecord::getAccuserCount() const {
-	return accusers.size();
+	return getAccusers().size();
 }
 
 bool CommitmentRecord::isAccuser(PartyId party) const {
+	auto const& accusers = getAccusers();
 	auto it = accusers.find(party);
 	return it != accusers.end();
 }
@@ -101,47 +166,222 @@ bool CommitmentRecord::isValueOpenTo(PartyId p) const {
 
 void CommitmentRecord::setOpenedValue(fmpz_t const& ov) {
 	//we reduce modulo p before we record, as we will often compare values
-	fmpz_set(openedValue, ov);
-	fmpz_mod(openedValue, openedValue, mod);
+	fmpz_mod(getOwnerState().openedValue, ov, mod);
 }
 
-fmpz_t const& CommitmentRecord::getOpenedValue() const {
+fmpz_t const& CommitmentRecord::getOpenedValue() {
 	if (!isValueOpenToUs()) {
 		throw runtime_error("Tried to retrieve value for unopened commitment.");
 	}
-	return openedValue;
+	materialize();
+	return getOwnerState().openedValue;
+}
+
+void CommitmentRecord::setLinearCombination(vector<LinearTerm> const& combination) {
+	materializeDependents();//they depend on the current value
+	unique_ptr<vector<LinearTerm>> flattened(new vector<LinearTerm>());
+	fmpz_t c;
+	fmpz_init(c);
+	for (auto const& t : combination) {
+		if (t.second != nullptr && t.second->isLazy()) {
+			//flatten, so that materializing never recurses into other lazy records
+			for (auto const& inner : *t.second->terms) {
+				fmpz_set_ui(c, inner.first);
+				fmpz_mul_ui(c, c, t.first);
+				fmpz_mod(c, c, mod);
+				addTerm(*flattened, fmpz_get_ui(c), inner.second);
+			}
+		} else if (t.second == this) {
+			throw runtime_error("Record can not be a term of its own linear combination : "+commitid);
+		} else {
+			addTerm(*flattened, t.first, t.second);
+		}
+	}
+	fmpz_clear(c);
+	releaseTerms();
+	terms = move(flattened);
+	for (auto const& t : *terms) {
+		if (t.second != nullptr) {
+			if (!t.second->dependents) {
+				t.second->dependents.reset(new vector<CommitmentRecord*>());
+			}
+			t.second->dependents->push_back(this);
+		}
+	}
+	lazy = true;
+}
+
+void CommitmentRecord::addTerm(vector<LinearTerm>& combination, ulong coeff, CommitmentRecord* cr) {
+	for (auto& t : combination) {
+		if (t.second == cr) {//merge terms with the same record
+			fmpz_t c;
+			fmpz_init_set_ui(c, t.first);
+			fmpz_add_ui(c, c, coeff);
+			fmpz_mod(c, c, mod);
+			t.first = fmpz_get_ui(c);
+			fmpz_clear(c);
+			return;
+		}
+	}
+	combination.push_back(LinearTerm(coeff, cr));
+}
+
+/**
+ * Drops the terms (without computing the combination), and unregisters this record from the term records
+ */
+void CommitmentRecord::releaseTerms() {
+	if (!terms) {
+		return;
+	}
+	for (auto const& t : *terms) {
+		if (t.second != nullptr) {
+			auto& deps = *t.second->dependents;
+			deps.erase(find(deps.begin(), deps.end(), this));
+			if (deps.empty()) {
+				t.second->dependents.reset();
+			}
+		}
+	}
+	terms.reset();
+	lazy = false;
+}
+
+/**
+ * Materializes all lazy records which have this record as a term, so that this record can change or go away.
+ */
+void CommitmentRecord::materializeDependents() {
+	while (dependents) {
+		dependents->back()->materialize();//(removes it from 'dependents')
+	}
+}
+
+/**
+ * True if this is a lazy record, and some of the records it depends on will not survive a cleanup.
+ */
+bool CommitmentRecord::dependsOnTemporary() const {
+	if (!terms) {
+		return false;
+	}
+	for (auto const& t : *terms) {
+		if (t.second != nullptr && !t.second->isPermanent()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void CommitmentRecord::materialize() {
+	if (!lazy) {
+		return;
+	}
+	lazy = false;
+	const bool own = (owner == recordHolder);//only the owner knows f(x,0)
+	fmpz_t c, constant;
+	fmpz_init(c);
+	fmpz_init(constant);
+	fmpz_zero(share);
+	fmpz_mod_poly_t term;
+	fmpz_mod_poly_init(term, mod);
+	if (own) {
+		fmpz_mod_poly_zero(getOwnerState().fx_0);
+	}
+	for (auto const& t : *terms) {
+		fmpz_set_ui(c, t.first);
+		if (t.second == nullptr) {
+			fmpz_add(constant, constant, c);
+		} else {
+			fmpz_addmul(share, c, t.second->getShare());//(materializes the term record, if it is lazy)
+			if (own) {
+				fmpz_mod_poly_scalar_mul_fmpz(term, t.second->getfx_0(), c);
+				fmpz_mod_poly_add(ownerState->fx_0, ownerState->fx_0, term);
+			}
+		}
+	}
+	//public commitment to a constant has f(x,y) = constant
+	fmpz_add(share, share, constant);
+	fmpz_mod(share, share, mod);//reduce
+	if (own) {
+		fmpz_mod_poly_get_coeff_fmpz(c, ownerState->fx_0, 0);
+		fmpz_add(c, c, constant);
+		fmpz_mod_poly_set_coeff_fmpz(ownerState->fx_0, 0, c);
+		fmpz_mod_poly_get_coeff_fmpz(ownerState->openedValue, ownerState->fx_0, 0);//f(0,0)
+	}
+	fmpz_mod_poly_clear(term);
+	fmpz_clear(constant);
+	fmpz_clear(c);
+	releaseTerms();
+}
+
+void CommitmentRecord::save(ostream& os) {
+	if (inprogress) {
+		throw runtime_error("Tried to save an ongoing commitment.");
+	}
+	materialize();
+	MathUtil::writeUlong(os, owner);
+	MathUtil::writeUlong(os, getDistributer());
+	const ulong flags = (success << 0) | (opened << 1) | (vssFlag << 2) | (mulTriple << 3) | (permanent << 4);
+	MathUtil::writeUlong(os, flags);
+	MathUtil::writeFmpz(os, share);
+	MathUtil::writeUlong(os, ownerState ? 1 : 0);//owner state is written only if present (an opened value may well be 0)
+	if (ownerState) {
+		MathUtil::writeFmpz(os, ownerState->openedValue);
+		MathUtil::writePoly(os, ownerState->fx_0);
+	}
+}
+
+void CommitmentRecord::load(istream& is) {
+	owner = MathUtil::readUlong(is);
+	const PartyId distributer = MathUtil::readUlong(is);
+	if (distributer != NOPARTY) {
+		setDistributer(distributer);
+	}
+	const ulong flags = MathUtil::readUlong(is);
+	inprogress = false;
+	success = flags & (1 << 0);
+	opened = flags & (1 << 1);
+	vssFlag = flags & (1 << 2);
+	mulTriple = flags & (1 << 3);
+	permanent = flags & (1 << 4);
+	MathUtil::readFmpz(is, share);
+	if (MathUtil::readUlong(is) == 1) {
+		MathUtil::readFmpz(is, getOwnerState().openedValue);
+		MathUtil::readPoly(is, getOwnerState().fx_0);
+	}
 }
 
 void CommitmentRecord::print(stringstream& ss) {
+	materialize();
 	ss << "---------------------Party" << to_string(recordHolder) << "---------------------" << endl;
 	ss << "Commitment ID : \t" << commitid << endl;
 	ss << "Owner : \t" << to_string(owner) << endl;
 	ss << "opened : \t" << to_string(opened) << endl;
-	if (!designatedOpenTargets.empty()) {
+	if (ownerState && !ownerState->designatedOpenTargets.empty()) {
 		ss << "designatedOpened to : \t";
-		for (auto const& p : designatedOpenTargets) {
+		for (auto const& p : ownerState->designatedOpenTargets) {
 			ss << to_string(p) << "\t";
 		}
 		ss << endl;
 	}
-	ss << "Opened Value : \t" << MathUtil::fmpzToStr(openedValue) << endl;
+	if (ownerState) {
+		ss << "Opened Value : \t" << MathUtil::fmpzToStr(ownerState->openedValue) << endl;
+	}
 	ss << "Share : \t" << MathUtil::fmpzToStr(share) << endl;
 	ss << "success : \t" << to_string(success) << endl;
 	ss << "inprogress : \t" << to_string(inprogress) << endl;
 	if (inprogress) {
-		ss << "inconsistentBroadcast : \t" << to_string(inconsistentBroadcast) << endl;
-		ss << "newVerifiableShareBroadcast : \t" << to_string(newVerifiableShareBroadcast) << endl;
+		ss << "inconsistentBroadcast : \t" << to_string(isInconsistentBroadcast()) << endl;
+		ss << "newVerifiableShareBroadcast : \t" << to_string(isNewVerifiableShareBroadcast()) << endl;
 	}
-	if (!disputes.empty()) {
+	if (!getDisputes().empty()) {
 		ss << "Disputes : \t" << endl;
-		for (auto const& d : disputes) {
+		for (auto const& d : getDisputes()) {
 			ss << to_string(d.disputer) << " -> " << to_string(d.disputed) << " : "
 					<< MathUtil::fmpzToStr(d.val) << " Opened : " << to_string(d.opened) << endl;
 		}
 	}
-	if (!accusers.empty()) {
+	if (!getAccusers().empty()) {
 		ss << "Accusers : \t" << endl;
-		for (auto const& ac : accusers) {
+		for (auto const& ac : getAccusers()) {
 			ss << to_string(ac) << "\t";
 		}
 		ss << endl;
@@ -27,9 +27,11 @@
 #ifndef COMMITRECORD_H_
 #define COMMITRECORD_H_
 
+#include <algorithm>
 #include <unordered_set>
 #include <vector>
 #include <sstream>
+#include <memory>
 #include "../message/DisputedValue.h"
 #include "../message/VerifiableShare.h"
 #include "Pceas.h"
@@ -41,7 +43,7 @@ namespace pceas {
 class CommitmentRecord {
 public:
 	CommitmentRecord(PartyId owner, fmpz_t const& m, PartyId recordHolder);
-	virtual ~CommitmentRecord();
+	~CommitmentRecord();//not virtual : nothing derives from records, and a vtable pointer per record would be wasted
 	PartyId getOwner() const {
 		return owner;
 	}
@@ -55,31 +57,37 @@ public:
 		this->commitid = commitid;
 	}
 	void setfx_0(fmpz_mod_poly_t const& poly) {
-		fmpz_mod_poly_set(fx_0.fkx, poly);
+		materialize();
+		materializeDependents();
+		fmpz_mod_poly_set(getOwnerState().fx_0, poly);
 	}
 	fmpz_mod_poly_t const& getfx_0() {
-		return fx_0.fkx;
+		materialize();
+		return getOwnerState().fx_0;
 	}
 	void setVerifiableShare(fmpz_mod_poly_t const& poly) {
-		fmpz_mod_poly_set(verifiableShare.fkx, poly);
+		fmpz_mod_poly_set(getOngoingState().verifiableShare.fkx, poly);
 	}
 	void setBroadcastVerifiableShare(fmpz_mod_poly_t const& poly) {
-		fmpz_mod_poly_set(broadcastVerifiableShare.fkx, poly);
-		newVerifiableShareBroadcast = true;
+		fmpz_mod_poly_set(getOngoingState().broadcastVerifiableShare.fkx, poly);
+		getOngoingState().newVerifiableShareBroadcast = true;
 	}
 	bool isNewVerifiableShareBroadcast() const {
-		return newVerifiableShareBroadcast;
+		return ongoing && ongoing->newVerifiableShareBroadcast;
 	}
 	fmpz_mod_poly_t const& getVerifiableShare() {
-		return verifiableShare.fkx;
+		return getOngoingState().verifiableShare.fkx;
 	}
 	fmpz_mod_poly_t const& getBroadcastVerifiableShare() {
-		return broadcastVerifiableShare.fkx;
+		return getOngoingState().broadcastVerifiableShare.fkx;
 	}
 	void setShare(fmpz_t const& s) {
+		materialize();
+		materializeDependents();
 		fmpz_set(share, s);
 	}
 	fmpz_t const& getShare() {
+		materialize();
 		return share;
 	}
 	void setOpened() {
@@ -89,13 +97,15 @@ public:
 		return opened;
 	}
 	void addDesignatedOpen(PartyId target) {
-		this->designatedOpenTargets.insert(target);
+		if (!isDesignatedOpenedTo(target)) {
+			getOwnerState().designatedOpenTargets.push_back(target);
+		}
 	}
 	bool isDesignatedOpenedTo(PartyId p) const {
-		return (designatedOpenTargets.find(p) != designatedOpenTargets.end());
+		return ownerState && (find(ownerState->designatedOpenTargets.begin(), ownerState->designatedOpenTargets.end(), p) != ownerState->designatedOpenTargets.end());
 	}
 	void setOpenedValue(fmpz_t const& ov);
-	fmpz_t const& getOpenedValue() const;
+	fmpz_t const& getOpenedValue();
 	bool isValueOpenTo(PartyId p) const;
 	bool isValueOpenToUs() const;
 	bool inProgress() const {
@@ -106,20 +116,20 @@ public:
 		this->success = result;
 	}
 	const vector<DisputedValue>& getDisputes() const {
-		return disputes;
+		return ongoing ? ongoing->disputes : NO_DISPUTES;
 	}
 	const unordered_set<PartyId>& getAccusers() const {
-		return accusers;
+		return ongoing ? ongoing->accusers : NO_ACCUSERS;
 	}
 	bool isInput() const {
 		return input;
 	}
 	void setInput(string label) {
 		this->input = true;
-		this->inputLabel = label;
+		getShareInfo().inputLabel = label;
 	}
 	const string& getInputLabel() const {
-		return inputLabel;
+		return shareInfo ? shareInfo->inputLabel : NO_NAME;
 	}
 	bool isOutput() const {
 		return output;
@@ -143,25 +153,25 @@ public:
 		this->permanent = true;
 	}
 	bool isInconsistentBroadcast() const {
-		return inconsistentBroadcast;
+		return ongoing && ongoing->inconsistentBroadcast;
 	}
 	void setInconsistentBroadcast() {
-		this->inconsistentBroadcast = true;
+		getOngoingState().inconsistentBroadcast = true;
 	}
 	bool isSuccess() const {
 		return success;
 	}
 	PartyId getDistributer() const {
-		return distributer;
+		return shareInfo ? shareInfo->distributer : NOPARTY;
 	}
 	void setDistributer(PartyId distributer) {
-		this->distributer = distributer;
+		getShareInfo().distributer = distributer;
 	}
 	const string& getShareNameSuffix() const {
-		return shareNameSuffix;
+		return shareInfo ? shareInfo->shareNameSuffix : NO_NAME;
 	}
 	void setShareNameSuffix(const string& shareNameSuffix) {
-		this->shareNameSuffix = shareNameSuffix;
+		getShareInfo().shareNameSuffix = shareNameSuffix;
 	}
 	bool isMulTriple() const {
 		return mulTriple;
@@ -175,36 +185,105 @@ public:
 	PartyId getAccuserCount() const;
 	bool isAccuser(PartyId party) const;
 
+	/*
+	 * A record can be left as a symbolic linear combination Ʃ c_i.<cid_i> of other records,
+	 * (a null record stands for the public commitment to 1). Share and f(x,0) of such a record
+	 * are computed only when they are first accessed, i.e. when the commitment is opened,
+	 * transferred or multiplied.
+	 * Each term record knows the lazy records that depend on it. These are materialized before the term record
+	 * changes (its share or f(x,0) is set, or it is re-assigned a combination), is removed from its table or is deleted.
+	 */
+	typedef pair<ulong, CommitmentRecord*> LinearTerm;//coefficient (reduced modulo p) - record pair
+	void setLinearCombination(vector<LinearTerm> const& combination);
+	bool isLazy() const {
+		return lazy;
+	}
+	bool dependsOnTemporary() const;
+	void materialize();
+	void materializeDependents();
+
+	void releaseOngoingState();
+	size_t getPolyBytes() const;
+	size_t getBytes() const;
+
 	void print(stringstream& ss);
+	/*
+	 * Completed records can be written to (and restored from) a binary stream, without the commitment ID.
+	 * (see 'Party::saveTripleStockpile')
+	 */
+	void save(ostream& os);
+	void load(istream& is);
 private:
+	void addTerm(vector<LinearTerm>& combination, ulong coeff, CommitmentRecord* cr);
+	void releaseTerms();
+
+	/*
+	 * State of an ongoing commitment. Only needed until the commitment is done,
+	 * so that completed records hold just the fields they use.
+	 */
+	struct OngoingState {
+		OngoingState(fmpz_t const& m) : verifiableShare(m), newVerifiableShareBroadcast(false), broadcastVerifiableShare(m), inconsistentBroadcast(false) {}
+		VerifiableShare verifiableShare; // Received from owner at Commit Step 1. Our verifiable share for this commitment.
+		bool newVerifiableShareBroadcast;
+		VerifiableShare broadcastVerifiableShare; // If a verifiable share is broadcast in Step 6 of commitment, we record it here
+		vector<DisputedValue> disputes;
+		unordered_set<PartyId> accusers; //parties who accused the owner
+		bool inconsistentBroadcast;//missing or inconsistent broadcast during ongoing commitment. All honest parties will agree on the value of this flag (without interaction).
+	};
+	OngoingState& getOngoingState();
+	/*
+	 * State of the commitment's value. Only the owner (and parties who had the commitment opened, or designatedOpen'ed,
+	 * to them) need it. Records of other parties' commitments, which make up most of each party's table, don't allocate it.
+	 */
+	struct OwnerState {
+		OwnerState(fmpz_t const& m) {
+			fmpz_mod_poly_init(fx_0, m);
+			fmpz_init(openedValue);
+		}
+		~OwnerState() {
+			fmpz_mod_poly_clear(fx_0);
+			fmpz_clear(openedValue);
+		}
+		fmpz_mod_poly_t fx_0; // f(x, 0). Owner stores this if commitment is successful. Later used for opening the commitment.
+		fmpz_t openedValue;
+		vector<PartyId> designatedOpenTargets;//parties who had this commitment 'designatedOpen'ed to them
+	};
+	OwnerState& getOwnerState();
+	/*
+	 * Where a share came from. Only set for shares received in a VSS (and for shares of inputs).
+	 */
+	struct ShareInfo {
+		ShareInfo() : distributer(NOPARTY) {}
+		PartyId distributer;//Party who distributed the share. (Receiver of a share becomes the owner as result of commitment transfer)
+		string inputLabel;
+		string shareNameSuffix;//'input sharing round number' for inputs, 'gate number' for others.
+	};
+	ShareInfo& getShareInfo();
+	static const vector<DisputedValue> NO_DISPUTES;
+	static const unordered_set<PartyId> NO_ACCUSERS;
+	static const string NO_NAME;
+
 	PartyId owner; // ID of the party who made the commitment
 	PartyId recordHolder;
 	fmpz_t mod;
 	CommitmentId commitid;
-	vector<DisputedValue> disputes;
-	unordered_set<PartyId> accusers; //parties who accused the owner
-	VerifiableShare verifiableShare; // Received from owner at Commit Step 1. Our verifiable share for this commitment.
-	bool newVerifiableShareBroadcast;
-	VerifiableShare broadcastVerifiableShare; // If a verifiable share is broadcast in Step 6 of commitment, we record it here
+	unique_ptr<OngoingState> ongoing;//null, unless commitment is in progress
+	unique_ptr<OwnerState> ownerState;//null for non-owners, unless the commitment is opened (or designatedOpen'ed)
 	fmpz_t share; // our share for this commitment
-	VerifiableShare fx_0; // f(x, 0). Owner stores this if commitment is successful. Later used for opening the commitment.
-	bool inconsistentBroadcast;//missing or inconsistent broadcast during ongoing commitment. All honest parties will agree on the value of this flag (without interaction).
+
+	unique_ptr<ShareInfo> shareInfo;//null, unless this is a distributed share
+	unique_ptr<vector<LinearTerm>> terms;//null, unless the record is lazy. Combinations are flattened when set, so term records are never lazy.
+	unique_ptr<vector<CommitmentRecord*>> dependents;//lazy records which have this record as a term. null, unless there are any.
+
 	bool inprogress;//true if commitment is in progress
 	bool success;//false if commitment failed and ended up in a forced publicCommit
-
 	bool opened;//is set to true when a commitment is opened with 'open'
-	bool designatedOpened;//is set to true when the commitment is opened to some party with 'designatedOpen'
-	unordered_set<PartyId> designatedOpenTargets;//set of parties who had this commitment 'designatedOpen'ed to them
-	fmpz_t openedValue;
-
 	bool input;//true if this a commitment to a share of an input
-	string inputLabel;
 	bool output;//true if this a commitment to a share of the output
 	bool vssFlag;//true if the commitment is being distributed (ongoing VSS)
 	bool permanent;//if true, record will persist after a cleanup
-	PartyId distributer;//Party who distributed the share. (Receiver of a share becomes the owner as result of commitment transfer)
-	string shareNameSuffix;//'input sharing round number' for inputs, 'gate number' for others.
 	bool mulTriple;//true if this record belongs to a multiplication triple (created during preprocessing of PCEAS with circuit randomization)
+	bool lazy;//true if share and f(x,0) are yet to be computed from 'terms'
 };
 
 } /* namespace pceas */
@@ -24,6 +24,7 @@
  *      Author: m3r7
  */
 
+#include <algorithm>
 #include "CommitmentTable.h"
 
 namespace pceas {
@@ -69,6 +70,7 @@ CommitmentId CommitmentTable::addRecord(PartyId owner, CommitmentId cid) {
 	CommitmentRecord* rec = new CommitmentRecord(owner, mod, pid);
 	rec->setCommitid(cid);
 	records.insert(make_pair(cid, rec));
+	recordAdded();
 	return cid;
 }
 
@@ -77,9 +79,17 @@ void CommitmentTable::addRecord(CommitmentRecord* cr) {
 		throw runtime_error("Bad commitment ID : "+cr->getCommitid());
 	}
 	records.insert(make_pair(cr->getCommitid(), cr));
+	recordAdded();
+}
+
+void CommitmentTable::recordAdded() {
+	stats.created++;
+	stats.peak = max(stats.peak, (ulong) records.size());
 }
 
 void CommitmentTable::removeRecord(CommitmentRecord* cr) {
+	cr->materialize();//the records it depends on stay in this table
+	cr->materializeDependents();//and the records depending on it must not refer to a record of another table
 	auto it = records.find(cr->getCommitid());
 	if (it == records.end()) {
 		throw runtime_error("Record not found : "+cr->getCommitid());
@@ -88,24 +98,34 @@ void CommitmentTable::removeRecord(CommitmentRecord* cr) {
 }
 
 bool CommitmentTable::exists(CommitmentId cid) const {
+	stats.lookups++;
 	return records.find(cid) != records.end();
 }
 
 CommitmentRecord* CommitmentTable::getRecord(CommitmentId cid) {
+	stats.lookups++;
 	auto it = records.find(cid);
 	if (it == records.end()) {
-		return nullptr;
+		if (!missingRecordHandler) {
+			return nullptr;
+		}
+		missingRecordHandler(cid);
+		it = records.find(cid);
+		if (it == records.end()) {
+			return nullptr;
+		}
 	}
 	return it->second;
 }
 
-CommitmentRecord* CommitmentTable::getRecordForOngoingCommitment(PartyId partyid) {
+vector<CommitmentRecord*> CommitmentTable::getRecordsForOngoingCommitments(PartyId partyid) const {
+	vector<CommitmentRecord*> crs;
 	for (auto const& pair : records) {
 		if (pair.second->getOwner() == partyid && pair.second->inProgress()) {
-			return pair.second;
+			crs.push_back(pair.second);
 		}
 	}
-	return nullptr;
+	return crs;
 }
 
 vector<CommitmentId> CommitmentTable::getOngoingCommits() const {
@@ -128,6 +148,19 @@ vector<CommitmentRecord*> CommitmentTable::getVSSharesReceivedBy(PartyId r) cons
 	return crs;
 }
 
+/**
+ * Shares received in the VSS identified by 'uniqueSuffix' (used when several VSSs run in a batch)
+ */
+vector<CommitmentRecord*> CommitmentTable::getVSSharesReceivedBy(PartyId r, string uniqueSuffix) const {
+	vector<CommitmentRecord*> crs;
+	for (auto const& pair : records) {
+		if (pair.second->isVss() && pair.second->getOwner() == r && pair.second->getShareNameSuffix() == uniqueSuffix) {
+			crs.push_back(pair.second);
+		}
+	}
+	return crs;
+}
+
 ulong CommitmentTable::getInputShareCountReceivedBy(PartyId r) const {
 	return getInputSharesReceivedBy(r).size();
 }
@@ -159,10 +192,17 @@ void CommitmentTable::clearVssFlags() {
 }
 
 void CommitmentTable::cleanUp() {
+	for (auto const& pair : records) {
+		if (pair.second->isPermanent() && pair.second->dependsOnTemporary()) {
+			pair.second->materialize();
+		}
+	}
+	stats.cleanups++;
 	for (auto it = records.begin(); it != records.end(); ) {
 		if (!it->second->isPermanent()) {
 			delete it->second;
 			it = records.erase(it);
+			stats.removedByCleanup++;
 		} else {
 			++it;
 		}
@@ -170,6 +210,7 @@ void CommitmentTable::cleanUp() {
 }
 
 void CommitmentTable::rename(CommitmentId oldName, CommitmentId newName) {
+	stats.renames++;
 	if (records.find(newName) != records.end()) {
 		throw runtime_error("Commitment ID already exists : "+newName);
 	}
@@ -191,6 +232,34 @@ CommitmentId CommitmentTable::getNextCommitId() {
 	return cid;
 }
 
+size_t CommitmentTable::getPolyBytes() const {
+	size_t bytes = 0;
+	for (auto const& pair : records) {
+		bytes += pair.second->getPolyBytes();
+	}
+	return bytes;
+}
+
+size_t CommitmentTable::getRecordBytes() const {
+	size_t bytes = 0;
+	for (auto const& pair : records) {
+		bytes += pair.second->getBytes();
+	}
+	return bytes;
+}
+
+void CommitmentTable::writeStatisticsHeader(ostream& os) {
+	os << "party,phase,gate,live_records,peak_records,poly_bytes,record_bytes,created,lookups,renames,cleanups,removed_by_cleanup" << endl;
+}
+
+/**
+ * Writes a single CSV line (see 'writeStatisticsHeader' for the columns)
+ */
+void CommitmentTable::writeStatistics(ostream& os, string phase, GateNumber gn) const {
+	os << pid << ',' << phase << ',' << gn << ',' << records.size() << ',' << stats.peak << ',' << getPolyBytes() << ',' << getRecordBytes() << ','
+	   << stats.created << ',' << stats.lookups << ',' << stats.renames << ',' << stats.cleanups << ',' << stats.removedByCleanup << endl;
+}
+
 void CommitmentTable::print(stringstream& ss) {
 	ss << endl << "//////////////////////////////////////////////////////////////" << endl;
 	ss << "Records for Party " << to_string(pid) << endl;
@@ -28,8 +28,10 @@
 #define COMMITTABLE_H_
 
 #include <string>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
+#include <functional>
 
 #include "CommitmentRecord.h"
 
@@ -47,22 +49,54 @@ public:
 	void removeRecord(CommitmentRecord* cr);
 	bool exists(CommitmentId cid) const;
 	CommitmentRecord* getRecord(CommitmentId cid);
-	CommitmentRecord* getRecordForOngoingCommitment(PartyId partyid);
+	vector<CommitmentRecord*> getRecordsForOngoingCommitments(PartyId partyid) const;
 	vector<CommitmentId> getOngoingCommits() const;
 	vector<CommitmentRecord*> getVSSharesReceivedBy(PartyId r) const;
+	vector<CommitmentRecord*> getVSSharesReceivedBy(PartyId r, string uniqueSuffix) const;
 	vector<CommitmentRecord*> getInputSharesReceivedBy(PartyId r) const;
 	vector<CommitmentRecord*> getOutputShares() const;
 	ulong getInputShareCountReceivedBy(PartyId r) const;
 	void clearVssFlags();
 	void cleanUp();
 	void rename(CommitmentId oldName, CommitmentId newName);
+	/**
+	 * Handler is given the chance to create a record, when a looked up record does not exist.
+	 */
+	void setMissingRecordHandler(function<void(CommitmentId)> handler) {
+		this->missingRecordHandler = handler;
+	}
+
+	/**
+	 * Counters for observing how the table grows during a run
+	 */
+	struct Statistics {
+		ulong created = 0;//records added
+		ulong peak = 0;//max number of live records
+		ulong lookups = 0;
+		ulong renames = 0;
+		ulong cleanups = 0;
+		ulong removedByCleanup = 0;
+	};
+	Statistics const& getStatistics() const {
+		return stats;
+	}
+	ulong size() const {
+		return records.size();
+	}
+	size_t getPolyBytes() const;
+	size_t getRecordBytes() const;
+	static void writeStatisticsHeader(ostream& os);
+	void writeStatistics(ostream& os, string phase, GateNumber gn) const;
 
 	void print(stringstream& ss);
 private:
+	mutable Statistics stats;
+	void recordAdded();
 	ulong counter;//counts the number of commitments. Used for making unique commit identifiers.
 	PartyId pid;
 	fmpz_t mod;
 	unordered_map<CommitmentId,CommitmentRecord*> records; // Holds 'commit ID' - 'record' pairs.
+	function<void(CommitmentId)> missingRecordHandler;
 	CommitmentId getNextCommitId();
 };
 
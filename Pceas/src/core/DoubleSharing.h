@@ -0,0 +1,51 @@
+/**************************************************************************************
+**
+** Copyright (C) 2017 Mert Dönmez
+**
+** This file is part of PCEAS
+**
+** PCEAS is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** PCEAS is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with PCEAS.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************************/
+/*
+ * DoubleSharing.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: m3r7
+ */
+
+#ifndef DOUBLESHARING_H_
+#define DOUBLESHARING_H_
+
+#include <fmpz.h>
+
+namespace pceas {
+
+/**
+ * Our Shamir shares [r]_D and [r]_2D of the same random value r, shared with polynomials of degree D and 2D.
+ * (Used by protocol 'CEPS' for degree reduction via a king)
+ */
+class DoubleSharing {
+public:
+	DoubleSharing();
+	virtual ~DoubleSharing();
+	DoubleSharing(DoubleSharing const&) = delete;
+	DoubleSharing& operator=(DoubleSharing const&) = delete;
+
+	fmpz_t rD;
+	fmpz_t r2D;
+};
+
+} /* namespace pceas */
+
+#endif /* DOUBLESHARING_H_ */
@@ -28,6 +28,8 @@
 #include <thread>
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <unordered_set>
 #include "../circuit/AdditionGate.h"
 #include "../circuit/ConstantMultGate.h"
@@ -57,44 +59,113 @@ Party::Party(PartyId pid, ulong partyCount, ulong threshold, ulong fieldPrime):p
 	interactive = false;
 	messagesReady = false;
 	circuit = nullptr;
+	randomizedCircuit = nullptr;
 	commitments = new CommitmentTable(pid, FIELD_PRIME);
 	secrets = new Secrets();
+	secretUpdates = new Secrets();
+	incrementalRun = false;
 	dataUser = 0;
+	session = 0;
 	done = false;
 	dishonest = false;
 	mu = new MathUtil(pid);
 	running = PROT_NONE;
+	onDemandMirroring = false;
+	statistics = nullptr;
+	offlineTripleCount = 0;
+	batchedVerificationRepetitions = 0;
+	robustOutputReconstruction = false;
+	optimisticCommitments = false;
+	cepsBeaverTriples = false;
+	kingDegreeReduction = false;
+	nextKing = 1;
+	packedInstances = 1;
+	packedRecombinationVectors = nullptr;
+	batchRows = 0;
 	maxDishonest = 0;
 }
 
 Party::~Party() {
 	delete circuit;
+	delete randomizedCircuit;
+	for (auto& c : batchCircuits) {
+		delete c;
+	}
 	fmpz_clear(FIELD_PRIME);
 	fmpz_clear(value);
 	fmpz_mod_poly_clear(poly);
 	_fmpz_vec_clear(recombinationVector, N);
 	_fmpz_vec_clear(shares, N);
 	_fmpz_vec_clear(multipointVec, N);
+	if (packedRecombinationVectors != nullptr) {
+		_fmpz_vec_clear(packedRecombinationVectors, packedInstances*N);
+	}
 	for (ulong i = 0; i < N; ++i) {
 		delete channels[i];
 	}
 	delete[] channels;
 	delete commitments;
 	delete secrets;
+	delete secretUpdates;
 	delete mu;
+	delete statistics;
+}
+
+/**
+ * Opens the file to which commitment table statistics will be written (see 'reportStatistics')
+ */
+void Party::setStatisticsFile(string path) {
+	delete statistics;
+	statistics = new ofstream(path);
+	if (!statistics->is_open()) {
+		throw runtime_error("Could not open statistics file : "+path);
+	}
+	CommitmentTable::writeStatisticsHeader(*statistics);
+}
+
+/**
+ * Enables batched verification of opened commitments (see 'countValidVerifiers'), failing with probability
+ * at most 2^-securityParameter. Each check fails with probability at most 1/p, hence the number of repetitions.
+ * 0 disables batched verification.
+ */
+void Party::setBatchedVerification(ulong securityParameter) {
+	const ulong bitsPerCheck = fmpz_sizeinbase(FIELD_PRIME, 2) - 1;//floor(log2(p))
+	batchedVerificationRepetitions = (securityParameter + bitsPerCheck - 1) / bitsPerCheck;
+}
+
+/**
+ * Writes a line of commitment table statistics for the phase (and gate) just completed.
+ */
+void Party::reportStatistics(string phase, GateNumber gn) {
+	if (statistics != nullptr) {
+		commitments->writeStatistics(*statistics, phase, gn);
+	}
 }
 
 void Party::runProtocol() {
 	try {
 		switch (running) {
 			case PCEPS:
-				runPceps();
+				if (!batchCircuits.empty()) {
+					runBatchPceps();
+				} else if (packedInstances > 1) {
+					runPackedPceps();
+				} else {
+					runPceps();
+				}
+				break;
+			case PCEPS_WITH_ABORT:
+				runPcepsWithAbort();
 				break;
 			case PCEAS:
 				runPceas(false);
 				break;
 			case PCEAS_WITH_CIRCUIT_RANDOMIZATION:
-				runPceas(true);
+				if (offlineTripleCount > 0) {
+					runOfflinePreprocessing();
+				} else {
+					runPceas(true);
+				}
 				break;
 			default:
 				throw runtime_error("Unknown protocol.");
@@ -109,33 +180,31 @@ void Party::runProtocol() {
 	}
 }
 
-void Party::runProtocolSequential(string prevRunResultLabel, Circuit* nextCircuit) {
+/**
+ * A session of runs over the same secret shared data, for 'CEAS' (with or without circuit randomization).
+ * Inputs are shared only once, in the first run (on 'circuit'). After run i, its result is kept as a committed wire labelled
+ * resultLabels[i], and nextCircuits[i] is evaluated next. A circuit may take any of the inputs, and the results of
+ * any of the previous runs, as its inputs. Only the committed wires are kept between runs, so each run pays only for its own gates.
+ */
+void Party::runProtocolSequential(vector<string> resultLabels, vector<Circuit*> nextCircuits) {
 	try {
+		if (resultLabels.size() != nextCircuits.size()) {
+			throw runtime_error("A label is required for the result of each run, except the last one.");
+		}
 		switch (running) {
 			case PCEAS:
+			case PCEAS_WITH_CIRCUIT_RANDOMIZATION:
 			{
-				runPceas(false, false);
-				//prepare for next run (note : we will keep the set of corrupt parties from previous run)
-				const string inputSharingUniqueSuffix = to_string(nextCircuit->getInputCount());//input count chosen as unique suffix so that we don't have name conflict with record names associated with inputs
-				const CommitmentId committedShareToResult = circuit->retrieveOutputCid();
-				CommitmentTable* tableForNextRun = new CommitmentTable(pid, FIELD_PRIME);
-				for (PartyId k = 1; k <= N; ++k) {
-					//locate records for the shares of result of previous run, before resetting commitment records
-					CommitmentId oldName_k = getShareNameFor(k, committedShareToResult);
-					CommitmentRecord* cr_k = commitments->getRecord(oldName_k);
-					//add records for the shares of result of previous run, to the table we will use for next run
-					CommitmentId newName_k = makeShareName(NOPARTY, k, inputSharingUniqueSuffix, true, false);
-					commitments->rename(oldName_k, newName_k);
-					cr_k->clearOutputFlag();//output of prev circuit
-					cr_k->setInput(prevRunResultLabel);//becomes input of next circuit
-					commitments->removeRecord(cr_k);
-					tableForNextRun->addRecord(cr_k);
-				}
-				swap(commitments, tableForNextRun);
-				delete tableForNextRun;//deleting table of records for first run
-				delete circuit;
-				circuit = nextCircuit;
-				runPceas(false, true);
+				const bool circuitRandomization = (running == PCEAS_WITH_CIRCUIT_RANDOMIZATION);
+				sessionWires.clear();
+				for (ulong i = 0; i < nextCircuits.size(); ++i) {
+					runPceas(circuitRandomization, false);
+					//prepare for next run (note : we will keep the set of corrupt parties from previous run)
+					keepSessionWire(resultLabels[i]);
+					delete circuit;
+					circuit = nextCircuits[i];
+				}
+				runPceas(circuitRandomization, true);
 				break;
 			}
 			default:
@@ -151,6 +220,122 @@ void Party::runProtocolSequential(string prevRunResultLabel, Circuit* nextCircui
 	}
 }
 
+/**
+ * Keeps the result of the current run as a committed wire labelled 'label', for the next runs of the session.
+ * Records of all parties' shares of the committed wires are moved to a fresh commitment table, and all other records are dropped.
+ */
+void Party::keepSessionWire(string label) {
+	if (sessionWires.find(label) != sessionWires.end()) {
+		throw PceasException("Label already in use : " + label);
+	}
+	const CommitmentId result = circuit->retrieveOutputCid();
+	for (PartyId k = 1; k <= N; ++k) {
+		CommitmentId oldName_k = getShareNameFor(k, result);
+		CommitmentRecord* cr_k = commitments->getRecord(oldName_k);
+		if (cr_k == nullptr) {
+			continue;
+		}
+		CommitmentId newName_k = makeShareName(NOPARTY, k, label, true, false);
+		commitments->rename(oldName_k, newName_k);
+		cr_k->clearOutputFlag();//output of prev circuit
+		cr_k->setInput(label);//becomes input of next circuits
+	}
+	sessionWires[label] = makeShareName(NOPARTY, pid, label, true, false);
+	CommitmentTable* tableForNextRun = new CommitmentTable(pid, FIELD_PRIME);
+	for (auto const& w : sessionWires) {
+		for (PartyId k = 1; k <= N; ++k) {
+			CommitmentRecord* cr_k = commitments->getRecord(getShareNameFor(k, w.second));
+			if (cr_k == nullptr) {
+				continue;
+			}
+			cr_k->materialize();//must not depend on records we are about to drop
+			commitments->removeRecord(cr_k);
+			tableForNextRun->addRecord(cr_k);
+		}
+	}
+	swap(commitments, tableForNextRun);
+	delete tableForNextRun;//deleting table of records for previous run
+	triples.clear();//triples are generated for each run (gate numbers restart)
+}
+
+/**
+ * Incremental re-evaluation for 'CEAS' (with or without circuit randomization).
+ * The circuit is evaluated once on all inputs, then again after the inputs in 'secretUpdates' change.
+ * In the second run, only updated inputs are shared (by the parties providing them), and only gates in the fan-out cone
+ * of the updated input wires are recomputed (multiplication triples are generated only for those).
+ * Committed wires of all other gates are kept from the first run.
+ */
+void Party::runProtocolIncremental() {
+	try {
+		switch (running) {
+			case PCEAS:
+			case PCEAS_WITH_CIRCUIT_RANDOMIZATION:
+			{
+				const bool circuitRandomization = (running == PCEAS_WITH_CIRCUIT_RANDOMIZATION);
+				runPceas(circuitRandomization, false);
+				prepareIncrementalRun();
+				runPceas(circuitRandomization, true);
+				break;
+			}
+			default:
+				throw runtime_error("Unsupproted protocol for incremental run.");
+				break;
+		}
+	} catch (PceasException& e) {
+		if (isCorrupt(pid)) {
+			end();
+		} else {
+			throw e;//something unexpected happened
+		}
+	}
+}
+
+/**
+ * Keeps records of all parties' shares of all input wires and gate results of the first run, in a fresh commitment table.
+ * All other records are dropped. Updated secrets become the secrets to share in the next run.
+ */
+void Party::prepareIncrementalRun() {
+	vector<CommitmentId> kept;
+	for (auto const& is : commitments->getInputSharesReceivedBy(pid)) {
+		kept.push_back(is->getCommitid());
+	}
+	for (auto const& g : circuit->getGates()) {
+		kept.push_back(makeShareName(NOPARTY, pid, to_string(g->getGateNumber()), false, false, true));
+	}
+	CommitmentTable* tableForNextRun = new CommitmentTable(pid, FIELD_PRIME);
+	for (auto const& cid : kept) {
+		for (PartyId k = 1; k <= N; ++k) {
+			CommitmentRecord* cr_k = commitments->getRecord(getShareNameFor(k, cid));
+			if (cr_k == nullptr) {
+				continue;
+			}
+			cr_k->materialize();//must not depend on records we are about to drop
+			cr_k->clearOutputFlag();
+			commitments->removeRecord(cr_k);
+			tableForNextRun->addRecord(cr_k);
+		}
+	}
+	swap(commitments, tableForNextRun);
+	delete tableForNextRun;//deleting table of records for previous run
+	triples.clear();//triples are generated again, for the gates to recompute
+	swap(secrets, secretUpdates);
+	incrementalRun = true;
+}
+
+/**
+ * Drops the records of all parties' shares of 'cid'
+ */
+void Party::dropRecords(CommitmentId cid) {
+	for (PartyId k = 1; k <= N; ++k) {
+		CommitmentId cid_k = getShareNameFor(k, cid);
+		if (commitments->exists(cid_k)) {
+			CommitmentRecord* cr_k = commitments->getRecord(cid_k);
+			commitments->removeRecord(cr_k);
+			delete cr_k;
+		}
+	}
+}
+
 /**
  * Protocol 'CEPS' (Circuit Evaluation with Passive Security)
  */
@@ -159,6 +344,21 @@ void Party::runPceps() {
 	sanityChecks();
 	setRecombinationVector();//calculate recombination vector
 
+	vector<GateNumber> gateNumbers;//MULT gates
+	for (auto const& g : circuit->getGates()) {
+		if (g->getType() == MULT) {
+			gateNumbers.push_back(g->getGateNumber());
+		}
+	}
+	if (kingDegreeReduction) {
+		// Preprocessing phase - a degree reduction is needed for each MULT gate (either online or while generating triples)
+		generateDoubleSharings(gateNumbers);//INTERACTIVE
+	}
+	if (cepsBeaverTriples) {
+		// Preprocessing phase - generates a multiplication triple for each MULT gate (independent of inputs)
+		generateBeaverTriples(gateNumbers);//INTERACTIVE
+	}
+
 	// Step 1 of 3 :input sharing
 	const unsigned long CIRCUIT_INPUT_NUM = circuit->getInputCount();
 	auto const& secretsMap = secrets->getSecrets();
@@ -195,59 +395,595 @@ void Party::runPceps() {
 			g->assignResult(g->getLocalResult());
 			break;
 		case MULT:
-			g->localCompute();
-			fmpz_mod(g->getLocalResult(), g->getLocalResult(), FIELD_PRIME);//reduce
-			distributeShares(g->getLocalResult());
+			if (cepsBeaverTriples) {
+				/*
+				 * MULT gates which are ready at the same time do not depend on each other.
+				 * For each of them, we open e = a - x and d = b - y together (the whole layer), via a king (see 'openViaKing').
+				 * Then [a * b] = [z] + e.[b] + d.[a] - e.d can be computed locally.
+				 */
+				vector<Gate*> layer = circuit->getReady(MULT);
+				fmpz* ed = _fmpz_vec_init(2*layer.size());//e and d of each gate
+				for (ulong j = 0; j < layer.size(); ++j) {
+					auto it = beaverTriples.find(layer[j]->getGateNumber());
+					if (it == beaverTriples.end()) {
+						throw PceasException("Missing triple.");
+					}
+					MultiplicationGate* mg = static_cast<MultiplicationGate*>(layer[j]);
+					fmpz_sub(ed+2*j, mg->getInputValue1(), it->second.x);// [e] = [a] - [x]
+					fmpz_mod(ed+2*j, ed+2*j, FIELD_PRIME);
+					fmpz_sub(ed+2*j+1, mg->getInputValue2(), it->second.y);// [d] = [b] - [y]
+					fmpz_mod(ed+2*j+1, ed+2*j+1, FIELD_PRIME);
+				}
+				openViaKing(ed, 2*layer.size(), "e, d");//INTERACTIVE
+				for (ulong j = 0; j < layer.size(); ++j) {
+					MultiplicationGate* mg = static_cast<MultiplicationGate*>(layer[j]);
+					BeaverTriple const& triple = beaverTriples.at(layer[j]->getGateNumber());
+					fmpz const* e = ed+2*j;
+					fmpz const* d = ed+2*j+1;
+					fmpz_set(value, triple.z);
+					fmpz_addmul(value, e, mg->getInputValue2());
+					fmpz_addmul(value, d, mg->getInputValue1());
+					fmpz_submul(value, e, d);
+					fmpz_mod(value, value, FIELD_PRIME);
+					layer[j]->assignResult(value);
+				}
+				_fmpz_vec_clear(ed, 2*layer.size());
+			} else {
+				g->localCompute();
+				fmpz_mod(g->getLocalResult(), g->getLocalResult(), FIELD_PRIME);//reduce
+				// We produce a degree D Shamir share, via degree reduction, by recombining local shares for a degree 2D polynomial
+				reduceDegree(g->getLocalResult(), 1, {g->getGateNumber()});//INTERACTIVE
+				g->assignResult(g->getLocalResult());
+			}
+			break;
+		}
+	}
+
+	// Step 3 of 3 : output reconstruction
+
+	// find output gate's output and send it privately to the data user
+	MessagePtr m = newMsg();
+	m->setShare(circuit->retrieveOutput());
+	channels[dataUser-1]->send(m);
+
+	interact();
+
+	if (pid == dataUser) {// data user performs interpolation to find f(0) and prints it
+		ulong receivedShareCount = 0;
+		_fmpz_vec_zero(shares, N);
+		for (ulong i = 0; i < N; ++i) {//receive shares sent by other parties
+			if (channels[i]->hasMsg()) {//T+1 shares will be enough, others will remain as zero (effectively excluding them from the upcoming dot product).
+				fmpz_set(shares+i, channels[i]->recv()->getShare());
+				receivedShareCount++;
+			}
+		}
+		if (receivedShareCount > D) {//need at least T = D+1 shares for interpolation
+			_fmpz_vec_dot(value, recombinationVector, shares, N);
+			fmpz_mod(value, value, FIELD_PRIME);
+			cout << "Evaluation result" << resultTag() << " : " << MathUtil::fmpzToStr(value) << endl;
+		} else {
+			cout << "Data user did not receive enough shares to recover evaluation result. "
+				 << "(Protocol cannot tolerate active cheaters.)" << endl;
+		}
+	}
+
+	end();
+}
+
+/**
+ * Protocol 'CEPS' with abort (security with abort, as in Chida et al., "Fast Large-Scale Honest-Majority MPC for Malicious Adversaries")
+ * The circuit is evaluated as in 'runPceps', together with 'randomizedCircuit' on r.x for each wire value x, where r is a secret random.
+ * For each MULT gate, [x.y] and [r.x.y] = [r.x].[y] are degree reduced together, so the rounds are those of 'runPceps'.
+ * Cheating parties can only add errors to products (or input an inconsistent r.x), which breaks the relation between the two copies.
+ * Before the output is delivered, all inputs and products z_k are checked in a batch : for public random α_k,
+ * Ʃ α_k.([r.z_k] - r.[z_k]) must be 0 (which fails to detect an error with probability at most (number of checked wires) / p).
+ * All values opened (r, the seed of α_k, the check value and the output) are opened with error detection (see 'openWithCheck').
+ * If any check fails, honest parties abort without delivering the output.
+ * (Beaver triples are not used in this mode, since they are generated passively)
+ */
+void Party::runPcepsWithAbort() {
+
+	sanityChecks();
+	setRecombinationVector();//calculate recombination vector
+
+	unordered_map<GateNumber, Gate*> randomizedGateOf;
+	for (auto const& rg : randomizedCircuit->getGates()) {
+		randomizedGateOf[rg->getGateNumber()] = rg;
+	}
+	ulong multCount = 0;
+	for (auto const& g : circuit->getGates()) {
+		if (g->getType() == MULT) {
+			multCount++;
+		}
+	}
+	const unsigned long CIRCUIT_INPUT_NUM = circuit->getInputCount();
+	const ulong CHECKED = CIRCUIT_INPUT_NUM + multCount;//(input or product) wires checked at the end
+	fmpz* z = _fmpz_vec_init(CHECKED);
+	fmpz* rz = _fmpz_vec_init(CHECKED);
+	fmpz* rs = _fmpz_vec_init(2);//our shares of r and s (the seed for α_k)
+	fmpz* opened = _fmpz_vec_init(2);
+	try {
+		if (kingDegreeReduction) {
+			// Preprocessing phase - a degree reduction is needed for each input and for both copies of each MULT gate
+			vector<GateNumber> reductions(CIRCUIT_INPUT_NUM, Gate::NO_GATE);//(inputs are not gates)
+			for (auto const& g : circuit->getGates()) {
+				if (g->getType() == MULT) {
+					reductions.insert(reductions.end(), 2, g->getGateNumber());
+				}
+			}
+			generateDoubleSharings(reductions);//INTERACTIVE
+		}
+
+		// Step 1 of 4 : input sharing
+		auto const& secretsMap = secrets->getSecrets();
+		auto it = secretsMap.begin();
+		vector<MessagePtr> messages;
+		while (messages.size() < CIRCUIT_INPUT_NUM) {
+			if (it != secretsMap.end()) {//if still has secrets to share
+				fmpz_set_ui(value, it->second);
+				distributeShares(value, it->first);
+				it++;
+			}
 
 			interact();
 
-			_fmpz_vec_zero(shares, N);
-			for (ulong i = 0; i < N; ++i) {//receive shares sent by other parties
-				//"outward clocking"
-				if (!channels[i]->hasMsg()) {//Even if the protocol could handle some missing shares, we stop here because our assumption(no active cheaters) is violated.
-					throw PceasException("A party fails to participate.");
+			for (ulong i = 0; i < N; ++i) {//receive shares sent
+				if (channels[i]->hasMsg()) {//only data providers are expected to send messages
+					messages.push_back(channels[i]->recv());
+				}
+			}
+		}
+		if (messages.size() > CIRCUIT_INPUT_NUM) {
+			throw PceasException("Received more inputs than expected.");
+		}
+		/*
+		 * r and s are the sums of randoms shared by all parties. s is opened only after all checked wires are fixed,
+		 * so that α_k are unknown to cheating parties while they can still change them.
+		 */
+		fmpz_randm(rs, mu->getRandState(), FIELD_PRIME);
+		fmpz_randm(rs+1, mu->getRandState(), FIELD_PRIME);
+		distributeShares(rs, 2);
+
+		interact();
+
+		_fmpz_vec_zero(rs, 2);
+		for (ulong i = 0; i < N; ++i) {
+			if (!channels[i]->hasMsg() || channels[i]->recv()->getBatchMessages().size() != 2) {
+				throw PceasException("A party fails to participate.");
+			}
+			auto const& received = channels[i]->recv()->getBatchMessages();
+			fmpz_add(rs, rs, received[0]->getShare());
+			fmpz_add(rs+1, rs+1, received[1]->getShare());
+		}
+		fmpz_mod(rs, rs, FIELD_PRIME);
+		fmpz_mod(rs+1, rs+1, FIELD_PRIME);
+		for (ulong j = 0; j < CIRCUIT_INPUT_NUM; ++j) {//[r.v] = [r].[v] for each input v
+			fmpz_set(z+j, messages[j]->getShare());
+			fmpz_mul(rz+j, rs, z+j);
+			fmpz_mod(rz+j, rz+j, FIELD_PRIME);
+		}
+		reduceDegree(rz, CIRCUIT_INPUT_NUM, {Gate::NO_GATE});//INTERACTIVE
+		for (ulong j = 0; j < CIRCUIT_INPUT_NUM; ++j) {
+			fmpz_set(value, z+j);
+			circuit->assignInput(value, messages[j]->getInputLabel());
+			fmpz_set(value, rz+j);
+			randomizedCircuit->assignInput(value, messages[j]->getInputLabel());
+		}
+
+		// Step 2 of 4 : computation (on both copies of the circuit)
+		ulong checked = CIRCUIT_INPUT_NUM;
+		Gate* g;
+		while ((g = circuit->getNext()) != nullptr) {
+			if (g->getType() != MULT) {
+				for (auto const& cg : {g, randomizedGateOf.at(g->getGateNumber())}) {
+					cg->localCompute();
+					fmpz_mod(cg->getLocalResult(), cg->getLocalResult(), FIELD_PRIME);//reduce
+					cg->assignResult(cg->getLocalResult());
+				}
+				continue;
+			}
+			//MULT gates which are ready at the same time do not depend on each other. We degree reduce all of them together.
+			vector<Gate*> layer = circuit->getReady(MULT);
+			const ulong L = layer.size();
+			fmpz* products = _fmpz_vec_init(2*L);//[x.y] of each gate, followed by [r.x.y] of each gate
+			vector<GateNumber> layerGateNumbers;
+			for (ulong j = 0; j < L; ++j) {
+				layerGateNumbers.push_back(layer[j]->getGateNumber());
+				MultiplicationGate* mg = static_cast<MultiplicationGate*>(layer[j]);
+				MultiplicationGate* rmg = static_cast<MultiplicationGate*>(randomizedGateOf.at(layer[j]->getGateNumber()));
+				fmpz_mul(products+j, mg->getInputValue1(), mg->getInputValue2());
+				fmpz_mod(products+j, products+j, FIELD_PRIME);
+				fmpz_mul(products+L+j, rmg->getInputValue1(), mg->getInputValue2());
+				fmpz_mod(products+L+j, products+L+j, FIELD_PRIME);
+#ifdef CEPS_WITH_ABORT_ADDITIVE_ATTACK
+				if (dishonest) {//A party adds an error to its share of a product before degree reduction.
+					//TEST CASE OK : Check fails, all honest parties abort, and the output is not delivered.
+					fmpz_add_ui(products+j, products+j, 1);
+					fmpz_mod(products+j, products+j, FIELD_PRIME);
+				}
+#endif
+			}
+			reduceDegree(products, 2*L, layerGateNumbers);//INTERACTIVE
+			for (ulong j = 0; j < L; ++j) {
+				Gate* rg = randomizedGateOf.at(layer[j]->getGateNumber());
+				fmpz_set(layer[j]->getLocalResult(), products+j);
+				layer[j]->assignResult(layer[j]->getLocalResult());
+				fmpz_set(rg->getLocalResult(), products+L+j);
+				rg->assignResult(rg->getLocalResult());
+				fmpz_set(z+checked, products+j);
+				fmpz_set(rz+checked, products+L+j);
+				checked++;
+			}
+			_fmpz_vec_clear(products, 2*L);
+		}
+
+		// Step 3 of 4 : verification (all checked wires are fixed by now)
+		if (!openWithCheck(rs, 2, opened)) {//INTERACTIVE
+			throw PceasException("Inconsistent shares of r, s.");
+		}
+		//[T] = Ʃ α_k.([r.z_k] - r.[z_k]), with α_k = s^(k+1)
+		fmpz_t t, alpha;
+		fmpz_init(t);
+		fmpz_init(alpha);
+		fmpz_set(alpha, opened+1);
+		for (ulong k = 0; k < checked; ++k) {
+			fmpz_mul(value, opened, z+k);
+			fmpz_sub(value, rz+k, value);
+			fmpz_addmul(t, alpha, value);
+			fmpz_mod(t, t, FIELD_PRIME);
+			fmpz_mul(alpha, alpha, opened+1);
+			fmpz_mod(alpha, alpha, FIELD_PRIME);
+		}
+		const bool consistent = openWithCheck(t, 1, opened);//INTERACTIVE
+		fmpz_clear(alpha);
+		fmpz_clear(t);
+		if (!consistent || !fmpz_is_zero(opened)) {
+			throw PceasException("Check of products failed.");
+		}
+
+		// Step 4 of 4 : output reconstruction
+		MessagePtr m = newMsg();
+		m->setShare(circuit->retrieveOutput());
+		channels[dataUser-1]->send(m);
+
+		interact();
+
+		if (pid == dataUser) {//data user needs all N shares, so that a wrong share is detected
+			fmpz_mod_poly_t f;
+			fmpz_mod_poly_init(f, FIELD_PRIME);
+			for (ulong i = 0; i < N; ++i) {
+				if (!channels[i]->hasMsg()) {
+					fmpz_mod_poly_clear(f);
+					throw PceasException("Missing output share.");
 				}
 				fmpz_set(shares+i, channels[i]->recv()->getShare());
 			}
-			// We produce a degree D Shamir share, via degree reduction, by recombining local shares for a degree 2D polynomial
-			_fmpz_vec_dot(g->getLocalResult(), recombinationVector, shares, N);
-			fmpz_mod(g->getLocalResult(), g->getLocalResult(), FIELD_PRIME);//reduce
-			g->assignResult(g->getLocalResult());
-			break;
+			MathUtil::interpolate(f, multipointVec, shares, N);
+			const bool consistentOutput = MathUtil::degreeCheckLTE(f, D);
+			fmpz_mod_poly_get_coeff_fmpz(value, f, 0);
+			fmpz_mod_poly_clear(f);
+			if (!consistentOutput) {
+				throw PceasException("Inconsistent output shares.");
+			}
+			cout << "Evaluation result" << resultTag() << " : " << MathUtil::fmpzToStr(value) << endl;
 		}
+	} catch (PceasException& e) {
+		cout << "Party " << pid << " aborts" << resultTag() << " : " << e.what() << endl;
 	}
+	_fmpz_vec_clear(z, CHECKED);
+	_fmpz_vec_clear(rz, CHECKED);
+	_fmpz_vec_clear(rs, 2);
+	_fmpz_vec_clear(opened, 2);
 
-	// Step 3 of 3 : output reconstruction
+	end();
+}
 
-	// find output gate's output and send it privately to the data user
+/**
+ * Opening with error detection (for 'CEPS' with abort)
+ * We broadcast our shares of 'count' values of degree D sharings. Since 2D < N, shares of honest parties determine each
+ * polynomial, so cheating parties can not change an opened value without the N shares failing to lie on a polynomial of degree D.
+ * Returns false if a party fails to participate or shares of a value are inconsistent. Otherwise, opened values are written to 'opened'.
+ */
+bool Party::openWithCheck(fmpz const* vals, ulong count, fmpz* opened) {
+	MessagePtr bm = newMsg();
+	bm->setDebugInfo("CEPS open with check : " + to_string(count) + " value(s)");
+	for (ulong j = 0; j < count; ++j) {
+		MessagePtr m = newMsg();
+		m->setShare(vals+j);
+		bm->addBatchMessage(m);
+	}
+	broadcast->broadcast(bm);
+
+	interact();
+
+	for (ulong i = 0; i < N; ++i) {
+		if (!broadcast->hasMsg(i+1) || broadcast->recv(i+1)->getBatchMessages().size() != count) {
+			return false;
+		}
+	}
+	bool consistent = true;
+	fmpz_mod_poly_t f;
+	fmpz_mod_poly_init(f, FIELD_PRIME);
+	for (ulong j = 0; j < count && consistent; ++j) {
+		for (ulong i = 0; i < N; ++i) {
+			fmpz_set(shares+i, broadcast->recv(i+1)->getBatchMessages()[j]->getShare());
+		}
+		MathUtil::interpolate(f, multipointVec, shares, N);
+		consistent = MathUtil::degreeCheckLTE(f, D);
+		fmpz_mod_poly_get_coeff_fmpz(opened+j, f, 0);
+	}
+	fmpz_mod_poly_clear(f);
+	return consistent;
+}
+
+/**
+ * Protocol 'CEPS' over 'packedInstances' instances of the circuit (SIMD evaluation)
+ * Secrets of all instances for an input are packed into a single polynomial (Franklin-Yung) of degree D + k - 1, so
+ * a single run evaluates all k instances at about the communication cost of one.
+ * Multiplication needs the product polynomial to be determined by N points, i.e. 2(D + k - 1) < N.
+ */
+void Party::runPackedPceps() {
+
+	sanityChecks();
+	const ulong K = packedInstances;
+	const ulong PD = D + K - 1;//degree of packed sharings
+	if (2*PD >= N) {
+		throw PceasException("Too many packed instances for the number of computing parties.");
+	}
+	if (fmpz_cmp_ui(FIELD_PRIME, N + PD + 1) <= 0) {//points of the instances and the random points must differ from the points of the parties
+		throw PceasException("Field too small for packed secret sharing.");
+	}
+	setRecombinationVector();
+	setPackedRecombinationVectors();
+
+	// Step 1 of 3 :input sharing
+	const unsigned long CIRCUIT_INPUT_NUM = circuit->getInputCount();
+	auto const& secretsMap = secrets->getInstanceSecrets();
+	auto it = secretsMap.begin();
+	fmpz* vals = _fmpz_vec_init(K);
+	vector<MessagePtr> messages;
+	while (messages.size() < CIRCUIT_INPUT_NUM) {
+		if (it != secretsMap.end()) {//if still has secrets to share
+			if (it->second.size() != K) {
+				throw PceasException("Secret with label " + it->first + " does not have a value for each instance.");
+			}
+			for (ulong j = 0; j < K; ++j) {
+				fmpz_set_ui(vals+j, it->second[j]);
+			}
+			distributePackedShares(vals, it->first);
+			it++;
+		}
+
+		interact();
+
+		for (ulong i = 0; i < N; ++i) {//receive shares sent
+			if (channels[i]->hasMsg()) {//only data providers are expected to send messages
+				messages.push_back(channels[i]->recv());
+			}
+		}
+	}
+	for (auto const& m : messages) {
+		circuit->assignInput(m->getShare(), m->getInputLabel());
+	}
+
+	// Step 2 of 3 : computation (ADD and CONST_MULT gates act on all instances at once, as in 'CEPS')
+	Gate* g;
+	while ((g = circuit->getNext()) != nullptr) {
+		g->localCompute();
+		fmpz_mod(g->getLocalResult(), g->getLocalResult(), FIELD_PRIME);//reduce
+		if (g->getType() == MULT) {
+			reducePackedDegree(g->getLocalResult());//INTERACTIVE
+		}
+		g->assignResult(g->getLocalResult());
+	}
+
+	// Step 3 of 3 : output reconstruction
 	MessagePtr m = newMsg();
 	m->setShare(circuit->retrieveOutput());
 	channels[dataUser-1]->send(m);
 
-	interact();
+	interact();
+
+	if (pid == dataUser) {// data user interpolates the packed polynomial and evaluates it at the point of each instance
+		fmpz* xs = _fmpz_vec_init(N);
+		fmpz* ys = _fmpz_vec_init(N);
+		ulong receivedShareCount = 0;
+		for (ulong i = 0; i < N; ++i) {
+			if (channels[i]->hasMsg()) {
+				fmpz_set(xs+receivedShareCount, multipointVec+i);
+				fmpz_set(ys+receivedShareCount, channels[i]->recv()->getShare());
+				receivedShareCount++;
+			}
+		}
+		if (receivedShareCount > PD) {//need at least PD + 1 shares for interpolation
+			fmpz_mod_poly_t f;
+			fmpz_mod_poly_init(f, FIELD_PRIME);
+			MathUtil::interpolate(f, xs, ys, PD+1);
+			for (ulong j = 1; j <= K; ++j) {
+				MathUtil::packedPoint(value, j, FIELD_PRIME);
+				fmpz_mod_poly_evaluate_fmpz(value, f, value);
+				cout << "Evaluation result (instance " << j << ") : " << MathUtil::fmpzToStr(value) << endl;
+			}
+			fmpz_mod_poly_clear(f);
+		} else {
+			cout << "Data user did not receive enough shares to recover evaluation result. "
+				 << "(Protocol cannot tolerate active cheaters.)" << endl;
+		}
+		_fmpz_vec_clear(xs, N);
+		_fmpz_vec_clear(ys, N);
+	}
+	_fmpz_vec_clear(vals, K);
+
+	end();
+}
+
+/**
+ * Protocol 'CEPS' over many rows of inputs (batch evaluation)
+ * Rows are evaluated chunk by chunk. Within a chunk, every step runs for all rows at once : a single (batch) message
+ * per party carries the values of all rows, so a chunk takes as many rounds as unbatched 'CEPS' on the same circuit.
+ * (MULT gates are still reduced gate by gate, not layer by layer.)
+ * The data user writes the result of each row to 'batchOutputPath' as soon as its chunk completes.
+ */
+void Party::runBatchPceps() {
+
+	sanityChecks();
+	setRecombinationVector();//calculate recombination vector
+
+	ofstream results;//(closed when we return, or when a 'PceasException' ends the run)
+	if (pid == dataUser) {
+		results.open(batchOutputPath);
+		if (!results.is_open()) {
+			throw runtime_error("Could not open batch output file : " + batchOutputPath);
+		}
+		results << "row,result" << endl;
+	}
+	const ulong CHUNK = batchCircuits.size();
+	const ulong CIRCUIT_INPUT_NUM = circuit->getInputCount();
+	auto const& secretsMap = secrets->getInstanceSecrets();
+	vector<GateNumber> multGateNumbers;
+	for (auto const& g : circuit->getGates()) {
+		if (g->getType() == MULT) {
+			multGateNumbers.push_back(g->getGateNumber());
+		}
+	}
+	fmpz* vals = _fmpz_vec_init(CHUNK);
+	for (ulong first = 0; first < batchRows; first += CHUNK) {
+		const ulong R = min(CHUNK, batchRows - first);//rows in this chunk
+		for (ulong r = 0; r < R; ++r) {
+			batchCircuits[r]->reset();
+		}
+		if (kingDegreeReduction) {
+			vector<GateNumber> reductions;//one for each row, for each MULT gate
+			for (auto const& gn : multGateNumbers) {
+				reductions.insert(reductions.end(), R, gn);
+			}
+			generateDoubleSharings(reductions);//INTERACTIVE
+		}
+
+		// Step 1 of 3 : input sharing (all secrets of a provider for all rows of the chunk, in a single message per party)
+		if (!secretsMap.empty()) {
+			MessagePtr messages[N];
+			for (ulong i = 0; i < N; ++i) {
+				messages[i] = newMsg();
+			}
+			fmpz_mod_poly_t f;
+			fmpz_mod_poly_init(f, FIELD_PRIME);
+			for (auto const& s : secretsMap) {
+				for (ulong r = 0; r < R; ++r) {
+					fmpz_set_ui(value, s.second.at(first+r));
+					mu->sampleUnivariate(f, value, D);
+					calculatePartyShares(f);
+					for (ulong i = 0; i < N; ++i) {
+						MessagePtr m = newMsg();
+						m->setShare(shares+i);
+						m->setInput(s.first);
+						messages[i]->addBatchMessage(m);
+					}
+				}
+			}
+			for (ulong i = 0; i < N; ++i) {
+				channels[i]->send(messages[i]);
+			}
+			fmpz_mod_poly_clear(f);
+		}
+
+		interact();
+
+		ulong assigned = 0;
+		for (ulong i = 0; i < N; ++i) {//only data providers are expected to send messages
+			if (channels[i]->hasMsg()) {
+				auto const& received = channels[i]->recv()->getBatchMessages();
+				for (ulong k = 0; k < received.size(); ++k) {//R consecutive shares (one for each row) for each label
+					batchCircuits[k % R]->assignInput(received[k]->getShare(), received[k]->getInputLabel());
+				}
+				assigned += received.size();
+			}
+		}
+		if (assigned != CIRCUIT_INPUT_NUM * R) {
+			throw PceasException("A party fails to participate.");
+		}
+
+		// Step 2 of 3 : computation (all copies of the circuit have the same gates, so they progress in lockstep)
+		vector<Gate*> const& gates = batchCircuits[0]->getGates();
+		for (ulong gi = 0; gi < gates.size();) {
+			if (gates[gi]->isProcessed() || !gates[gi]->isReady()) {
+				gi++;
+				continue;
+			}
+			for (ulong r = 0; r < R; ++r) {
+				Gate* g = batchCircuits[r]->getGates()[gi];
+				g->localCompute();
+				fmpz_mod(vals+r, g->getLocalResult(), FIELD_PRIME);//reduce
+			}
+			if (gates[gi]->getType() == MULT) {
+				reduceDegree(vals, R, {gates[gi]->getGateNumber()});//INTERACTIVE
+			}
+			for (ulong r = 0; r < R; ++r) {
+				Gate* g = batchCircuits[r]->getGates()[gi];
+				fmpz_set(g->getLocalResult(), vals+r);
+				g->assignResult(g->getLocalResult());
+			}
+			gi = 0;//as 'getNext', continue with the ready gate with smallest gate number
+		}
+
+		// Step 3 of 3 : output reconstruction (outputs of all rows of the chunk in a single message)
+		MessagePtr om = newMsg();
+		for (ulong r = 0; r < R; ++r) {
+			MessagePtr m = newMsg();
+			m->setShare(batchCircuits[r]->retrieveOutput());
+			om->addBatchMessage(m);
+		}
+		channels[dataUser-1]->send(om);
 
-	if (pid == dataUser) {// data user performs interpolation to find f(0) and prints it
-		ulong receivedShareCount = 0;
-		_fmpz_vec_zero(shares, N);
-		for (ulong i = 0; i < N; ++i) {//receive shares sent by other parties
-			if (channels[i]->hasMsg()) {//T+1 shares will be enough, others will remain as zero (effectively excluding them from the upcoming dot product).
-				fmpz_set(shares+i, channels[i]->recv()->getShare());
-				receivedShareCount++;
+		interact();
+
+		if (pid == dataUser) {
+			vector<MessagePtr> received(N);
+			for (ulong i = 0; i < N; ++i) {
+				if (!channels[i]->hasMsg() || channels[i]->recv()->getBatchMessages().size() != R) {
+					throw PceasException("A party fails to participate.");
+				}
+				received[i] = channels[i]->recv();
 			}
-		}
-		if (receivedShareCount > D) {//need at least T = D+1 shares for interpolation
-			_fmpz_vec_dot(value, recombinationVector, shares, N);
-			fmpz_mod(value, value, FIELD_PRIME);
-			cout << "Evaluation result : " << MathUtil::fmpzToStr(value) << endl;
-		} else {
-			cout << "Data user did not receive enough shares to recover evaluation result. "
-				 << "(Protocol cannot tolerate active cheaters.)" << endl;
+			for (ulong r = 0; r < R; ++r) {
+				for (ulong i = 0; i < N; ++i) {
+					fmpz_set(shares+i, received[i]->getBatchMessages()[r]->getShare());
+				}
+				_fmpz_vec_dot(value, recombinationVector, shares, N);
+				fmpz_mod(value, value, FIELD_PRIME);
+				results << (first + r + 1) << "," << MathUtil::fmpzToStr(value) << "\n";
+			}
+			results.flush();
+			cout << "Evaluation results written for rows " << (first + 1) << " - " << (first + R) << endl;
 		}
 	}
+	_fmpz_vec_clear(vals, CHUNK);
 
 	end();
 }
 
+/**
+ * Each party commits to all of its secrets, and distributes shares of all of them in a single batched VSS.
+ * Parties may provide different numbers of inputs. A party without any input commits to and distributes nothing,
+ * but participates in the VSSs of others. (No party can provide more than CIRCUIT_INPUT_NUM inputs.)
+ * The j-th secret of each party is distinguished with unique suffix uniqueSuffixOf(j).
+ */
+void Party::shareInputs(function<string(ulong)> const& uniqueSuffixOf) {
+	const unsigned long CIRCUIT_INPUT_NUM = circuit->getInputCount();
+	auto const& secretsMap = secrets->getSecrets();
+	const ulong secretCount = min<ulong>(secretsMap.size(), CIRCUIT_INPUT_NUM);
+	fmpz* vals = _fmpz_vec_init(secretCount);
+	vector<string> labels;
+	for (auto it = secretsMap.begin(); labels.size() < secretCount; ++it) {
+		fmpz_set_ui(vals+labels.size(), it->second);
+		labels.push_back(it->first);
+	}
+	const vector<CommitmentId> inputCids = commit(vals, secretCount);//INTERACTIVE
+	_fmpz_vec_clear(vals, secretCount);
+	distributeVerifiableShares(inputCids, uniqueSuffixOf, labels, false, true, CIRCUIT_INPUT_NUM);//INTERACTIVE
+	commitments->cleanUp();//to keep commitment table size managable, we remove records which are no longer needed
+}
+
 /**
  * Protocol 'CEAS' (Circuit Evaluation with Active Security)
  */
@@ -256,37 +992,74 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 	sanityChecks();
 //	circuit->sortGates(); //necessary if order based input-wire matching is used
 	setRecombinationVector();//note : we will recalculate recombination vector each time we mark a party as corrupt
+	deferredMirrors.clear();
+	if (onDemandMirroring) {
+		commitments->setMissingRecordHandler([this](CommitmentId cid){deriveMirroredRecord(cid);});
+	}
 
-	if (circuitRandomization) {
-		// Preprocessing phase for 'CEAS with Circuit Randomization' - generates multiplication triples
+	if (circuitRandomization && !incrementalRun) {
+		// Preprocessing phase for 'CEAS with Circuit Randomization' - generates (or loads) multiplication triples
 		runPreprocessing();
 		commitments->cleanUp();//to keep commitment table size managable, we remove records which are no longer needed
+		reportStatistics("preprocessing");
 	}
 
-	{// Step 1 of 3 :input sharing
-		const unsigned long CIRCUIT_INPUT_NUM = circuit->getInputCount();
-		auto const& secretsMap = secrets->getSecrets();
-		auto it = secretsMap.begin();
-		ulong inputSharingLoopCounter = 0;//any single party will loop at most CIRCUIT_INPUT_NUM times. we use this fact to break loop and end protocol if any dishonest refuse to distribute a share.
-		while (commitments->getInputShareCountReceivedBy(pid) < CIRCUIT_INPUT_NUM && inputSharingLoopCounter < CIRCUIT_INPUT_NUM) {
-			const string inputSharingUniqueSuffix = to_string(inputSharingLoopCounter);
-			if (it != secretsMap.end()) {//distribute shares of each secret
-				fmpz_set_ui(value, it->second);
-				distributeVerifiableShares(value, inputSharingUniqueSuffix, it->first, false, true);
-				it++;
-			} else {
-				/*
-				 * Note : Ideally, if a party does not have any input to distribute, it should just
-				 * passively participate in distribution process of others (VSS is highly interactive).
-				 * For simplifying the implementation, we make these parties distribute some arbitrary value,
-				 * which will be ignored. This does not increase the number of rounds required.
-				 */
-				fmpz_zero(value);
-				distributeVerifiableShares(value, inputSharingUniqueSuffix, NONE, false, true);
+	if (incrementalRun) {// Step 1 of 3 : (in an incremental run) only updated inputs are shared, and only gates depending on them are recomputed
+		unordered_set<CommitmentId> previousInputs;
+		for (auto const& is : commitments->getInputSharesReceivedBy(pid)) {
+			previousInputs.insert(is->getCommitid());
+		}
+		shareInputs([](ulong j){return "update" + to_string(j);});//INTERACTIVE
+		unordered_map<string, CommitmentRecord*> updates;
+		for (auto const& is : commitments->getInputSharesReceivedBy(pid)) {
+			if (previousInputs.find(is->getCommitid()) == previousInputs.end()
+					&& !updates.insert(make_pair(is->getInputLabel(), is)).second) {
+				throw PceasException("Input updated more than once : " + is->getInputLabel());
 			}
-			inputSharingLoopCounter++;
 		}
-		commitments->cleanUp();//to keep commitment table size managable, we remove records which are no longer needed
+		unordered_set<string> labels;
+		vector<CommitmentId> staleInputs;
+		for (auto const& u : updates) {
+			if (circuit->getLabels().count(u.first) == 0) {
+				throw PceasException("Unknown input label : " + u.first);
+			}
+			for (auto const& cid : previousInputs) {
+				CommitmentRecord* cr = commitments->getRecord(cid);
+				if (cr->getInputLabel() == u.first) {
+					if (cr->getDistributer() != u.second->getDistributer()) {
+						throw PceasException("Input can only be updated by the party providing it : " + u.first);
+					}
+					staleInputs.push_back(cid);
+				}
+			}
+			labels.insert(u.first);
+		}
+		for (auto const& g : circuit->markDirty(labels)) {//results of dirty gates are dropped before the inputs they depend on
+			dropRecords(makeShareName(NOPARTY, pid, to_string(g->getGateNumber()), false, false, true));
+		}
+		for (auto const& cid : staleInputs) {
+			dropRecords(cid);
+		}
+		for (auto const& u : updates) {
+			circuit->assignInputCid(u.second->getCommitid(), u.first);
+		}
+		reportStatistics("input_sharing");
+		if (circuitRandomization) {
+			runPreprocessing();//(only for dirty gates)
+			commitments->cleanUp();//to keep commitment table size managable, we remove records which are no longer needed
+			reportStatistics("preprocessing");
+		}
+	} else if (!sessionWires.empty()) {// Step 1 of 3 : (in a later run of a session) inputs are the committed wires kept from previous runs
+		for (auto const& label : circuit->getLabels()) {
+			auto it = sessionWires.find(label);
+			if (it == sessionWires.end()) {
+				throw PceasException("Unknown input label : " + label);
+			}
+			circuit->assignInputCid(it->second, label);
+		}
+	} else {// Step 1 of 3 :input sharing
+		const unsigned long CIRCUIT_INPUT_NUM = circuit->getInputCount();
+		shareInputs([](ulong j){return to_string(j);});//INTERACTIVE
 		vector<CommitmentRecord*> inputShares = commitments->getInputSharesReceivedBy(pid);
 		if (inputShares.size() < CIRCUIT_INPUT_NUM) {
 			throw PceasException("Missing inputs.");
@@ -309,11 +1082,15 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 //		});
 		for (auto const& is : inputShares) {
 			circuit->assignInputCid(is->getCommitid(), is->getInputLabel());
+			if (!finalRun) {//first run of a session, inputs are kept for the runs to follow
+				sessionWires[is->getInputLabel()] = is->getCommitid();
+			}
 #ifdef VERBOSE
 			cout << "Party " << to_string(pid) << " assigns wire " + is->getInputLabel() + " : \nCID = " << is->getCommitid()
 				 << "\nOpenedVal = " << MathUtil::fmpzToStr(is->getOpenedValue()) << endl;
 #endif
 		}
+		reportStatistics("input_sharing");
 	}
 	interact();
 #ifdef VERBOSE
@@ -326,187 +1103,166 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 		case ADD:
 		{
 			AdditionGate* ag = static_cast<AdditionGate*>(g);
-			for (PartyId k = 1; k <= N; ++k) {
-				/*
-				 * To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
-				 */
-				const CommitmentId share_k_1 = getShareNameFor(k, ag->getInputCid1());
-				const CommitmentId share_k_2 = getShareNameFor(k, ag->getInputCid2());
-				CommitmentId add_k = addCommitments(share_k_1, share_k_2);
-				CommitmentId result_k = makeShareName(NOPARTY, k, to_string(g->getGateNumber()), false, false, true);
-				commitments->rename(add_k, result_k);
-				CommitmentRecord* cr_k = commitments->getRecord(result_k);
-				if (cr_k == nullptr || cr_k->getOwner() != k) {//should not happen
-					throw PceasException("Wire is assigned invalid commitment.");
-				}
-				cr_k->setPermanent();
-				if (k == pid) {
-					g->assignResult(cr_k->getCommitid());
-#ifdef VERBOSE
-					cout << "Party " << to_string(pid) << " assigns output to gate# " << g->getGateNumber() << " (addition gate) : \nCID = "
-						 << cr_k->getCommitid() << "\nOpenedValue = " << MathUtil::fmpzToStr(cr_k->getOpenedValue()) << endl;
-#endif
-				}
-			}
+			GateRecipe recipe;
+			recipe.coeffs = {1, 1};
+			recipe.operands = {ag->getInputCid1(), ag->getInputCid2()};
+			mirrorGateResult(g, [recipe](PartyId k){return recipe;});
 		}
 		break;
 		case CONST_MULT:
 		{
 			ConstantMultGate* cmg = static_cast<ConstantMultGate*>(g);
-			for (PartyId k = 1; k <= N; ++k) {
-				/*
-				 * To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
-				 */
-				const CommitmentId share_k = getShareNameFor(k, cmg->getInputCid());
-				CommitmentId mult_k = constMultCommitment(cmg->getConstant(), share_k);
-				CommitmentId result_k = makeShareName(NOPARTY, k, to_string(g->getGateNumber()), false, false, true);
-				commitments->rename(mult_k, result_k);
-				CommitmentRecord* cr_k = commitments->getRecord(result_k);
-				if (cr_k == nullptr || cr_k->getOwner() != k) {//should not happen
-					throw PceasException("Wire is assigned invalid commitment.");
-				}
-				cr_k->setPermanent();
-				if (k == pid) {
-					g->assignResult(cr_k->getCommitid());
-#ifdef VERBOSE
-					cout << "Party " << to_string(pid) << " assigns output to gate# " << g->getGateNumber() << " (const. mult. gate) : \nCID = "
-						 << cr_k->getCommitid() << "\nOpenedValue = " << MathUtil::fmpzToStr(cr_k->getOpenedValue()) << endl;
-#endif
-				}
-			}
+			GateRecipe recipe;
+			recipe.coeffs = {reduce(cmg->getConstant())};
+			recipe.operands = {cmg->getInputCid()};
+			mirrorGateResult(g, [recipe](PartyId k){return recipe;});
 		}
 		break;
 		case MULT:
 		{
-			MultiplicationGate* mg = static_cast<MultiplicationGate*>(g);
 			if (circuitRandomization) {
-				//construct a common representation (common to all honest parties) for a * b, using existing multiplication triples (generated in preprocessing phase)
-				auto it = triples.find(g->getGateNumber()); // x, y, x*y
-				if (it == triples.end()) {
-					throw PceasException("Missing triple.");
-				}
-				CommitmentId e_pid, d_pid;
-				for (PartyId k = 1; k <= N; ++k) {//To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
-					const CommitmentId input1_k = getShareNameFor(k, mg->getInputCid1());
-					const CommitmentId input2_k = getShareNameFor(k, mg->getInputCid2());
-					CommitmentId e = substractCommitments(input1_k, makeTripleName(k, MultiplicationTriple::M1, g->getGateNumber())); // a - x
-					CommitmentId d = substractCommitments(input2_k, makeTripleName(k, MultiplicationTriple::M2, g->getGateNumber())); // b - y
-					CommitmentId eNew = makeTripleName(k, MultiplicationTriple::E, g->getGateNumber());
-					CommitmentId dNew = makeTripleName(k, MultiplicationTriple::D, g->getGateNumber());
-					commitments->rename(e, eNew);
-					commitments->rename(d, dNew);
-					if (k == pid) {
-						e_pid = eNew;
-						d_pid = dNew;
+				/*
+				 * MULT gates which are ready at the same time do not depend on each other.
+				 * We open e and d for all of them (the whole layer) together.
+				 */
+				vector<Gate*> layer = circuit->getReady(MULT);
+				vector<CommitmentId> myOpens;
+				for (auto const& lg : layer) {
+					//construct a common representation (common to all honest parties) for a * b, using existing multiplication triples (generated in preprocessing phase)
+					if (triples.find(lg->getGateNumber()) == triples.end()) {
+						throw PceasException("Missing triple.");
+					}
+					MultiplicationGate* mg = static_cast<MultiplicationGate*>(lg);
+					for (PartyId k = 1; k <= N; ++k) {//To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
+						const CommitmentId input1_k = getShareNameFor(k, mg->getInputCid1());
+						const CommitmentId input2_k = getShareNameFor(k, mg->getInputCid2());
+						CommitmentId e = substractCommitments(input1_k, makeTripleName(k, MultiplicationTriple::M1, lg->getGateNumber())); // a - x
+						CommitmentId d = substractCommitments(input2_k, makeTripleName(k, MultiplicationTriple::M2, lg->getGateNumber())); // b - y
+						CommitmentId eNew = makeTripleName(k, MultiplicationTriple::E, lg->getGateNumber());
+						CommitmentId dNew = makeTripleName(k, MultiplicationTriple::D, lg->getGateNumber());
+						commitments->rename(e, eNew);
+						commitments->rename(d, dNew);
+						if (k == pid) {
+							myOpens.push_back(eNew);
+							myOpens.push_back(dNew);
+						}
 					}
 				}
 				/*
 				 * We open e and d, and other parties will open theirs(e' = a - x', d' = b - y')
-				 * Note that, these 'open's are the only interactions we need in order to process the multiplication gate.
+				 * Note that, these 'open's are the only interactions we need in order to process the multiplication gates.
 				 * Via circuit randomization, much of the cost due to interactions for multiplications are pushed
-				 * to the preprocessing phase, in which triples are (ideally - see 'runPreprocessing') generated
-				 * in parallel, rather than one at a a time.
+				 * to the preprocessing phase, in which triples are generated in parallel (see 'runPreprocessing').
 				 */
-				open(e_pid);//INTERACTIVE
-				open(d_pid);//INTERACTIVE
-				MultiplicationTriple& triple = it->second;
-				auto& receivedShares = triple.receivedShares;
-				CommitmentId result_pid;
-				//eliminate shares for which the sender of share is known to be dishonest (we marked parties as corrupt in previous steps)
-				receivedShares.erase(remove_if(receivedShares.begin(), receivedShares.end(), [this](CommitmentRecord* cr){return isCorrupt(cr->getDistributer());}), receivedShares.end());
-				if (receivedShares.size() > 2*D) {
+				open(myOpens);//INTERACTIVE
+				for (auto const& lg : layer) {
+					for (PartyId k = 1; k <= N; ++k) {
+						CommitmentRecord* ek = commitments->getRecord(makeTripleName(k, MultiplicationTriple::E, lg->getGateNumber()));
+						CommitmentRecord* dk = commitments->getRecord(makeTripleName(k, MultiplicationTriple::D, lg->getGateNumber()));
+						if (!isCorrupt(k) && (ek == nullptr || !ek->isOpened() || dk == nullptr || !dk->isOpened())) {
+							addCorrupt(k);//all honest will agree.
+						}
+					}
+				}
+				for (auto const& lg : layer) {
+					MultiplicationGate* mg = static_cast<MultiplicationGate*>(lg);
+					MultiplicationTriple& triple = triples[lg->getGateNumber()]; // x, y, x*y
+					auto& receivedShares = triple.receivedShares;
+					//eliminate shares for which the sender of share is known to be dishonest (we marked parties as corrupt in previous steps)
+					receivedShares.erase(remove_if(receivedShares.begin(), receivedShares.end(), [this](CommitmentRecord* cr){return isCorrupt(cr->getDistributer());}), receivedShares.end());
+					if (receivedShares.size() <= 2*D) {
+						/*
+						 * Since deg(h) = 2D, we needed more than 2D shares for recombination.
+						 * This protocol tolerates <= N / 3 dishonest.
+						 * Not having enough shares means, our assumption failed. We stop execution..
+						 */
+						throw PceasException("More dishonest than the protocol can handle.");
+					}
 					sort(receivedShares.begin(), receivedShares.end(), [](CommitmentRecord* is1, CommitmentRecord* is2){return is1->getDistributer() < is2->getDistributer();});
-					result_pid = runDegreeReduction(receivedShares, g->getGateNumber());
-#ifdef VERBOSE
-					this_thread::sleep_for(chrono::milliseconds(pid*700));
-					cout << "Party " << to_string(pid) << " recombined x.y : " << MathUtil::fmpzToStr(commitments->getRecord(result_pid)->getOpenedValue()) << endl;
-#endif
-				} else {
+					const GateRecipe productRecipe = runDegreeReduction(receivedShares); // [[x * y]]
 					/*
-					 * Since deg(h) = 2D, we needed more than 2D shares for recombination.
-					 * This protocol tolerates <= N / 3 dishonest.
-					 * Not having enough shares means, our assumption failed. We stop execution..
+					 * Opened values are shares of e and d. We recombine them, so that all parties use the same (public) e and d.
+					 * (Using its own shares of e and d, each party would end up with a share of a * b on a polynomial of degree 2D)
 					 */
-					throw PceasException("More dishonest than the protocol can handle.");
-				}
-				for (PartyId k = 1; k <= N; ++k) {//To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
-					CommitmentRecord* ek = commitments->getRecord(makeTripleName(k, MultiplicationTriple::E, g->getGateNumber()));
-					CommitmentRecord* dk = commitments->getRecord(makeTripleName(k, MultiplicationTriple::D, g->getGateNumber()));
-					if (ek == nullptr || !ek->isOpened() || dk == nullptr || !dk->isOpened()) {
-						addCorrupt(k);//all honest will agree
-						if (k == pid) {//keep corrupt parties alive for running test cases
-							g->assignResult(result_pid);
+					fmpz_t e, d;
+					fmpz_init(e);
+					fmpz_init(d);
+					const char* types[] = {MultiplicationTriple::E, MultiplicationTriple::D};
+					fmpz* publicValues[] = {e, d};
+					for (ulong i = 0; i < 2; ++i) {
+						_fmpz_vec_zero(shares, N);
+						for (PartyId k = 1; k <= N; ++k) {
+							if (!isCorrupt(k)) {
+								fmpz_set(shares+k-1, commitments->getRecord(makeTripleName(k, types[i], lg->getGateNumber()))->getOpenedValue());
+							}
 						}
-						continue;
+						_fmpz_vec_dot(value, recombinationVector, shares, N);
+						fmpz_mod(publicValues[i], value, FIELD_PRIME);
 					}
-					const CommitmentId input1_k = getShareNameFor(k, mg->getInputCid1());
-					const CommitmentId input2_k = getShareNameFor(k, mg->getInputCid2());
-					const CommitmentId result_k = makeShareName(NOPARTY, k, to_string(g->getGateNumber()), false, false, true);
-					CommitmentId temp_k = makeTripleName(k, MultiplicationTriple::PROD, g->getGateNumber());
 					//[[a * b]] = [[x * y]] + e[[b]] + d[[a]] - e.d
-					commitments->rename(result_k, temp_k);//initialize temp_k with [[x * y]]
-					temp_k = addCommitments(temp_k, constMultCommitment(ek->getOpenedValue(), input2_k)); // result_k += e[[b]]
-					temp_k = addCommitments(temp_k, constMultCommitment(dk->getOpenedValue(), input1_k)); // result_k += d[[a]]
-					fmpz_mul(value, ek->getOpenedValue(), dk->getOpenedValue());
-#ifdef VERBOSE
-					if (k == pid) {
-						cout << "Party " << to_string(pid) << "a,b : " << MathUtil::fmpzToStr(commitments->getRecord(input1_k)->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(commitments->getRecord(input2_k)->getOpenedValue()) << endl;
-						cout << " a.b + e.d : " << MathUtil::fmpzToStr(commitments->getRecord(temp_k)->getOpenedValue()) << "  e.d : " << MathUtil::fmpzToStr(value) << endl;
-					}
-#endif
+					GateRecipe productOfInputs = productRecipe;
+					productOfInputs.coeffs.push_back(reduce(e));
+					productOfInputs.operands.push_back(mg->getInputCid2());
+					productOfInputs.coeffs.push_back(reduce(d));
+					productOfInputs.operands.push_back(mg->getInputCid1());
+					fmpz_mul(value, e, d);
 					fmpz_neg(value, value);
-					temp_k = constAddCommitment(value, temp_k); // result_k -= e.d
-					commitments->rename(temp_k, result_k);
-					CommitmentRecord* cr_k = commitments->getRecord(result_k);
-					if (cr_k == nullptr || cr_k->getOwner() != k) {//should not happen
-						throw PceasException("Wire is assigned invalid commitment.");
-					}
-					cr_k->setPermanent();
-					if (k == pid) {
-						g->assignResult(cr_k->getCommitid());
-#ifdef VERBOSE
-						cout << "Party " << to_string(pid) << " assigns output to gate# " << g->getGateNumber() << " (mult. gate) : \nCID = "
-							 << cr_k->getCommitid() << "\nOpenedValue = " << MathUtil::fmpzToStr(cr_k->getOpenedValue()) << endl;
-
-						cout << "Triple used were (M1, M2, E, D) : " <<  MathUtil::fmpzToStr(triple.firstMult->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(triple.secontMult->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(commitments->getRecord(e_pid)->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(commitments->getRecord(d_pid)->getOpenedValue()) << endl;
-						cout << "Received shares were : " << endl;
-						for (auto const& s : receivedShares) {
-							cout << MathUtil::fmpzToStr(s->getOpenedValue()) << "\t";
+					productOfInputs.constant = reduce(value);
+					fmpz_clear(e);
+					fmpz_clear(d);
+					vector<GateRecipe> recipes(N, productRecipe);//(we keep [[x * y]] for corrupt parties to keep them alive for running test cases)
+					for (PartyId k = 1; k <= N; ++k) {
+						if (!isCorrupt(k)) {
+							recipes[k-1] = productOfInputs;
 						}
-						cout << endl;
-#endif
 					}
+					mirrorGateResult(lg, [recipes](PartyId k){return recipes[k-1];});
 				}
 			} else {
+				/*
+				 * MULT gates which are ready at the same time do not depend on each other.
+				 * We multiply commitments for all of them (the whole layer) together.
+				 * (Gates multiplying the same pair of inputs are left to a later layer, since their products would share a commitment ID)
+				 */
+				vector<Gate*> layer;
+				vector< pair<CommitmentId, CommitmentId> > pairs;
+				unordered_set<CommitmentId> productIds;
+				for (auto const& lg : circuit->getReady(MULT)) {
+					MultiplicationGate* lmg = static_cast<MultiplicationGate*>(lg);
+					if (productIds.insert(getMultipliedCommitId(lmg->getInputCid1(), lmg->getInputCid2())).second) {
+						layer.push_back(lg);
+						pairs.push_back(make_pair(lmg->getInputCid1(), lmg->getInputCid2()));
+					}
+				}
 				/*
 				 * [[ab;f.g]]_2t = [[a;f]]_t * [[b;g]]_t
 				 */
-				CommitmentId localMult = multiplyCommitments(mg->getInputCid1(), mg->getInputCid2());
-				distributeVerifiableShares(localMult, to_string(g->getGateNumber()));
-				vector<CommitmentRecord*> receivedShares = commitments->getVSSharesReceivedBy(pid);
-				//eliminate shares for which the sender of share is known to be dishonest (we marked parties as corrupt in previous steps)
-				receivedShares.erase(remove_if(receivedShares.begin(), receivedShares.end(), [this](CommitmentRecord* cr){return isCorrupt(cr->getDistributer());}), receivedShares.end());
-				if (receivedShares.size() > 2*D) {
-					sort(receivedShares.begin(), receivedShares.end(), [](CommitmentRecord* is1, CommitmentRecord* is2){return is1->getDistributer() < is2->getDistributer();});
-					CommitmentId result = runDegreeReduction(receivedShares, g->getGateNumber());
-					g->assignResult(result);
-#ifdef VERBOSE
-					cout << "Party " << to_string(pid) << " assigns output to gate# " << g->getGateNumber() << " (mult. gate) : \nCID = "
-						 << result << "\nOpenedValue = " << MathUtil::fmpzToStr(commitments->getRecord(result)->getOpenedValue()) << endl;
-#endif
-				} else {
-					/*
-					 * Since deg(h) = 2D, we needed more than 2D shares for recombination.
-					 * This protocol tolerates <= N / 3 dishonest.
-					 * Not having enough shares means, our assumption failed. We stop execution..
-					 */
-					throw PceasException("More dishonest than the protocol can handle.");
+				vector<CommitmentId> localMults = multiplyCommitments(pairs);
+				//products of the whole layer are shared in a single batched VSS (shares of each gate are named with its gate number)
+				distributeVerifiableShares(localMults, [&layer](ulong j){return to_string(layer[j]->getGateNumber());}, vector<string>(layer.size(), NONE));
+				for (ulong j = 0; j < layer.size(); ++j) {
+					vector<CommitmentRecord*> receivedShares = commitments->getVSSharesReceivedBy(pid, to_string(layer[j]->getGateNumber()));
+					//eliminate shares for which the sender of share is known to be dishonest (we marked parties as corrupt in previous steps)
+					receivedShares.erase(remove_if(receivedShares.begin(), receivedShares.end(), [this](CommitmentRecord* cr){return isCorrupt(cr->getDistributer());}), receivedShares.end());
+					if (receivedShares.size() > 2*D) {
+						sort(receivedShares.begin(), receivedShares.end(), [](CommitmentRecord* is1, CommitmentRecord* is2){return is1->getDistributer() < is2->getDistributer();});
+						const GateRecipe recipe = runDegreeReduction(receivedShares);
+						mirrorGateResult(layer[j], [recipe](PartyId k){return recipe;});
+					} else {
+						/*
+						 * Since deg(h) = 2D, we needed more than 2D shares for recombination.
+						 * This protocol tolerates <= N / 3 dishonest.
+						 * Not having enough shares means, our assumption failed. We stop execution..
+						 */
+						throw PceasException("More dishonest than the protocol can handle.");
+					}
 				}
 			}
 		}
 		break;
 		}
 		commitments->cleanUp();//to keep commitment table size managable, we remove records which are no longer needed
+		reportStatistics("computation", g->getGateNumber());
 	}
 	interact();
 #ifdef VERBOSE
@@ -516,19 +1272,17 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 		// Step 3 of 3 : output reconstruction
 		// find output gate's output and send it privately to the data user
 		CommitmentId result = circuit->retrieveOutputCid();
-		for (ulong i = 0; i < N; ++i) {//since parties can not designatedOpen to the same party in parallel, they will take turns
-			PartyId k = i + 1;
-			if (k != dataUser) {
-				if (k == pid) {//our turn to 'designatedOpen' share to dataUser
-					designatedOpen(result, dataUser, true);//INTERACTIVE
-				} else {//We will not 'designatedOpen' anything, but will participate in other's 'designatedOpen's.
-					//note that single share per party is automatically enforced due to target selection scheme used in 'designatedOpen'
-					const PartyId target = getTargetFromSource(pid, k, dataUser);//(when party k is opening to dataUser, we can only open to...)
-					designatedOpen(NONE, target, true);//INTERACTIVE
-				}
-			}
+		if (robustOutputReconstruction) {
+			reconstructOutputRobustly(result);//INTERACTIVE (no 'designatedOpen's, data user decodes the output)
+		} else {
+			/*
+			 * All parties (except the data user) 'designatedOpen' their shares to dataUser at once.
+			 * Rejected shares are opened in a single batched 'open' within the same 'designatedOpen'.
+			 * (The data user does not 'designatedOpen' to self, but participates.)
+			 */
+			designatedOpen((pid != dataUser) ? result : NONE, dataUser, true);//INTERACTIVE
 		}
-		if (pid == dataUser) {
+		if (pid == dataUser && !robustOutputReconstruction) {
 			//We mark the share we have as output. (we did not 'designatedOpen' to self.
 			//Shares from other parties have been marked during the 'designatedOpen's above.)
 			commitments->getRecord(result)->markAsOutput();
@@ -547,7 +1301,7 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 				}
 				_fmpz_vec_dot(value, recombinationVector, shares, N);
 				fmpz_mod(value, value, FIELD_PRIME);
-				cout << "Evaluation result : " << MathUtil::fmpzToStr(value) << endl;
+				cout << "Evaluation result" << resultTag() << " : " << MathUtil::fmpzToStr(value) << endl;
 			} else {
 				/*
 				 * Since deg(f) = D, we needed more than D shares for recombination.
@@ -558,6 +1312,7 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 					 << "(More dishonest than the protocol can handle)" << endl;
 			}
 		}
+		reportStatistics("output");
 	}
 	if (finalRun) {
 		end();
@@ -566,6 +1321,76 @@ void Party::runPceas(bool circuitRandomization, bool finalRun) {
 	}
 }
 
+/**
+ * Robust output reconstruction
+ *
+ * Parties send their shares of the output privately to the data user, in a single round and without any verification.
+ * Shares of honest parties lie on a polynomial of degree D, and there are at most D incorrect shares.
+ * Since N > 3D (enforced in 'sanityChecks'), the data user can correct up to (N - D - 1) / 2 >= D errors with Reed-Solomon decoding,
+ * and the parties whose shares are off the decoded polynomial are identified as cheaters.
+ * (Only the data user learns who cheated here. Other parties can not verify this, so they are not marked as corrupt.
+ * The data user keeps them in 'outputCheaters' instead, and ignores their shares from then on.
+ * An ignored share is an erasure, which costs half as much of the decoding capacity as an incorrect share.)
+ */
+void Party::reconstructOutputRobustly(CommitmentId result) {
+	if (pid != dataUser) {
+		MessagePtr m = newMsg();
+		m->setDebugInfo("robust output reconstruction");
+		fmpz_set(value, commitments->getRecord(result)->getOpenedValue());//we are the owner, the value is known to us
+#ifdef OUTPUT_SEND_INVALID_SHARE
+		if (dishonest) {//A party sends a wrong share of the output.
+			//TEST CASE OK : Data user decodes the correct result, and identifies the party as a cheater.
+			fmpz_add_ui(value, value, 1);
+			fmpz_mod(value, value, FIELD_PRIME);
+		}
+#endif
+		m->setShare(value);
+		channels[dataUser-1]->send(m);
+	}
+	interact();
+	if (pid == dataUser) {
+		fmpz* xs = _fmpz_vec_init(N);
+		fmpz* ys = _fmpz_vec_init(N);
+		vector<PartyId> senders;
+		for (PartyId k = 1; k <= N; ++k) {
+			if (isCorrupt(k)) {//(all honest agree on parties known to be corrupt, we don't need their shares)
+				continue;
+			}
+			if (outputCheaters.count(k) != 0) {//cheated in a previous output reconstruction
+				continue;
+			}
+			if (k == pid) {
+				fmpz_set(ys+senders.size(), commitments->getRecord(result)->getOpenedValue());
+			} else if (channels[k-1]->hasMsg()) {
+				fmpz_mod(ys+senders.size(), channels[k-1]->recv()->getShare(), FIELD_PRIME);
+			} else {
+				continue;//a missing share is an erasure
+			}
+			fmpz_set(xs+senders.size(), multipointVec+k-1);
+			senders.push_back(k);
+		}
+		if (senders.size() > D && MathUtil::decodeReedSolomon(poly, xs, ys, senders.size(), D)) {
+			fmpz_mod_poly_get_coeff_fmpz(value, poly, 0);
+			cout << "Evaluation result" << resultTag() << " : " << MathUtil::fmpzToStr(value) << endl;
+			for (ulong i = 0; i < senders.size(); ++i) {
+				fmpz_mod_poly_evaluate_fmpz(value, poly, xs+i);
+				if (fmpz_equal(value, ys+i) == 0) {
+					outputCheaters.insert(senders[i]);
+				}
+			}
+		} else {
+			/*
+			 * There were more incorrect (or missing) shares than we could correct.
+			 * This protocol tolerates <= N / 3 dishonest.
+			 */
+			cout << "Data user could not decode the evaluation result. "
+				 << "(More dishonest than the protocol can handle)" << endl;
+		}
+		_fmpz_vec_clear(xs, N);
+		_fmpz_vec_clear(ys, N);
+	}
+}
+
 /**
  * Secret sharing.
  * Distributes shares [a;f_a]_t
@@ -586,9 +1411,323 @@ void Party::distributeShares(fmpz_t const& val, string label) {
 		if (label != NONE) {
 			m->setInput(label);
 		}
-		channels[i]->send(m);
+		channels[i]->send(m);
+	}
+	fmpz_mod_poly_clear(f);
+}
+
+/**
+ * Packed secret sharing
+ * Distributes shares of a single polynomial carrying the 'packedInstances' values 'vals' (see 'MathUtil::samplePacked')
+ */
+void Party::distributePackedShares(fmpz const* vals, string label) {
+	fmpz_mod_poly_t f;
+	fmpz_mod_poly_init(f, FIELD_PRIME);
+	mu->samplePacked(f, vals, packedInstances, D + packedInstances - 1);
+	calculatePartyShares(f);
+	for (ulong i = 0; i < N; ++i) {
+		MessagePtr m = newMsg();
+		m->setShare(shares+i);
+		if (label != NONE) {
+			m->setInput(label);
+		}
+		channels[i]->send(m);
+	}
+	fmpz_mod_poly_clear(f);
+}
+
+/**
+ * Degree reduction for packed sharings (passive)
+ * 'val' is our share h(i) of the product polynomial, of degree 2(D + k - 1), carrying a * b of each instance j at point -j.
+ * Instance j's product is Ʃ λ_ji.h(i) (λ_ji : Lagrange coefficient of party i for point -j), so we pack our terms λ_ji.h(i)
+ * for all j into a new sharing. Adding up the packed sharings received from all parties gives a sharing of degree D + k - 1
+ * for all products.
+ */
+void Party::reducePackedDegree(fmpz_t& val) {
+	const ulong K = packedInstances;
+	fmpz* terms = _fmpz_vec_init(K);
+	for (ulong j = 0; j < K; ++j) {
+		fmpz_mul(terms+j, packedRecombinationVectors+j*N+pid-1, val);
+		fmpz_mod(terms+j, terms+j, FIELD_PRIME);
+	}
+	distributePackedShares(terms);
+	_fmpz_vec_clear(terms, K);
+
+	interact();
+
+	fmpz_zero(val);
+	for (ulong i = 0; i < N; ++i) {
+		if (!channels[i]->hasMsg()) {//every share of the product polynomial is needed
+			throw PceasException("A party fails to participate.");
+		}
+		fmpz_add(val, val, channels[i]->recv()->getShare());
+	}
+	fmpz_mod(val, val, FIELD_PRIME);
+}
+
+/**
+ * Batched secret sharing.
+ * Distributes shares of each of the 'count' values, with a single message for each party.
+ */
+void Party::distributeShares(fmpz const* vals, ulong count) {
+	fmpz_mod_poly_t f;
+	fmpz_mod_poly_init(f, FIELD_PRIME);
+	MessagePtr messages[N];
+	for (ulong i = 0; i < N; ++i) {
+		messages[i] = newMsg();
+	}
+	for (ulong j = 0; j < count; ++j) {
+		fmpz_set(value, vals+j);
+		mu->sampleUnivariate(f, value, D);
+		calculatePartyShares(f);
+		for (ulong i = 0; i < N; ++i) {
+			MessagePtr m = newMsg();
+			m->setShare(shares+i);
+			messages[i]->addBatchMessage(m);
+		}
+	}
+	for (ulong i = 0; i < N; ++i) {
+		channels[i]->send(messages[i]);
+	}
+	fmpz_mod_poly_clear(f);
+}
+
+/**
+ * Degree reduction (passive)
+ * 'vals' hold our shares of 'count' degree 2D polynomials (e.g. local products).
+ * Each is replaced with our share of a degree D polynomial for the same secret, by resharing
+ * the 2D-shares and recombining the received shares.
+ * 'vals[j]' belongs to gate 'gateNumbers[j % gateNumbers.size()]'. (Only used when reducing via a king)
+ */
+void Party::reduceDegree(fmpz* vals, ulong count, vector<GateNumber> const& gateNumbers) {
+	if (kingDegreeReduction) {
+		reduceDegreeViaKing(vals, count, gateNumbers);//INTERACTIVE
+		return;
+	}
+	distributeShares(vals, count);
+
+	interact();
+
+	vector<MessagePtr> received(N);
+	for (ulong i = 0; i < N; ++i) {//receive shares sent by other parties
+		//"outward clocking"
+		if (!channels[i]->hasMsg() || channels[i]->recv()->getBatchMessages().size() != count) {//Even if the protocol could handle some missing shares, we stop here because our assumption(no active cheaters) is violated.
+			throw PceasException("A party fails to participate.");
+		}
+		received[i] = channels[i]->recv();
+	}
+	for (ulong j = 0; j < count; ++j) {
+		for (ulong i = 0; i < N; ++i) {
+			fmpz_set(shares+i, received[i]->getBatchMessages()[j]->getShare());
+		}
+		_fmpz_vec_dot(vals+j, recombinationVector, shares, N);
+		fmpz_mod(vals+j, vals+j, FIELD_PRIME);//reduce
+	}
+}
+
+/**
+ * Degree reduction via a king (passive), as in Damgård-Nielsen
+ * Consumes the double sharings ([r]_D, [r]_2D) generated for 'gateNumbers' in preprocessing phase : 'vals[j]' is masked with
+ * the (j / G)-th double sharing of gate 'gateNumbers[j % G]', where G = gateNumbers.size(). All double sharings of these gates
+ * must be used by this call.
+ * The masked values [v]_2D + [r]_2D are opened via a king (see 'openViaKing'). Then [v]_D = (v + r) - [r]_D.
+ * This takes 2N messages per call instead of N^2, at the cost of an extra round.
+ */
+void Party::reduceDegreeViaKing(fmpz* vals, ulong count, vector<GateNumber> const& gateNumbers) {
+	const ulong G = gateNumbers.size();
+	for (auto const& gn : gateNumbers) {
+		auto it = doubleSharings.find(gn);
+		if (it == doubleSharings.end() || it->second.size() * G != count) {
+			throw PceasException("Missing double sharing.");
+		}
+	}
+	for (ulong j = 0; j < count; ++j) {
+		fmpz_add(vals+j, vals+j, doubleSharings.at(gateNumbers[j % G])[j / G].r2D);
+		fmpz_mod(vals+j, vals+j, FIELD_PRIME);
+	}
+	openViaKing(vals, count, "masked 2D-shares");//INTERACTIVE
+	for (ulong j = 0; j < count; ++j) {
+		fmpz_sub(vals+j, vals+j, doubleSharings.at(gateNumbers[j % G])[j / G].rD);
+		fmpz_mod(vals+j, vals+j, FIELD_PRIME);
+	}
+	for (auto const& gn : gateNumbers) {
+		doubleSharings.erase(gn);
+	}
+}
+
+/**
+ * Opening via a king (passive)
+ * 'vals' hold our shares of 'count' values (of degree up to 2D). Every party sends its shares to the king, who reconstructs
+ * the values and sends them back to everyone. 'vals' are replaced with the opened values.
+ * This takes 2N messages (in two rounds), instead of the N^2 of everyone sending its shares to everyone.
+ * Kings take turns, and a king is never skipped : like the rest of 'CEPS', this assumes that all parties follow the protocol
+ * (passive security). A king who does not respond makes the run fail.
+ */
+void Party::openViaKing(fmpz* vals, ulong count, string what) {
+	const PartyId king = nextKing;
+	nextKing = (nextKing % N) + 1;//kings take turns, to balance the load
+
+	MessagePtr toKing = newMsg();
+	toKing->setDebugInfo(what + " for king : " + to_string(count) + " value(s)");
+	for (ulong j = 0; j < count; ++j) {
+		MessagePtr m = newMsg();
+		m->setShare(vals+j);
+		toKing->addBatchMessage(m);
+	}
+	channels[king-1]->send(toKing);
+
+	interact();
+
+	if (pid == king) {//king reconstructs the values and sends them to everyone
+		vector<MessagePtr> received(N);
+		for (ulong i = 0; i < N; ++i) {
+			if (!channels[i]->hasMsg() || channels[i]->recv()->getBatchMessages().size() != count) {
+				throw PceasException("A party fails to participate.");
+			}
+			received[i] = channels[i]->recv();
+		}
+		for (ulong i = 0; i < N; ++i) {
+			MessagePtr opened = newMsg();
+			opened->setDebugInfo("king opens " + what + " : " + to_string(count) + " value(s)");
+			for (ulong j = 0; j < count; ++j) {
+				for (ulong k = 0; k < N; ++k) {
+					fmpz_set(shares+k, received[k]->getBatchMessages()[j]->getShare());
+				}
+				MessagePtr m = newMsg();
+				_fmpz_vec_dot(value, recombinationVector, shares, N);//N points determine a degree 2D polynomial
+				fmpz_mod(value, value, FIELD_PRIME);
+				m->setShare(value);
+				opened->addBatchMessage(m);
+			}
+			channels[i]->send(opened);
+		}
+	}
+
+	interact();
+
+	if (!channels[king-1]->hasMsg() || channels[king-1]->recv()->getBatchMessages().size() != count) {
+		throw PceasException("A party fails to participate.");
+	}
+	auto const& opened = channels[king-1]->recv()->getBatchMessages();
+	for (ulong j = 0; j < count; ++j) {
+		fmpz_set(vals+j, opened[j]->getShare());
+	}
+}
+
+/**
+ * Preprocessing for 'CEPS' with king based degree reduction
+ * Generates a double sharing ([r]_D, [r]_2D) for each entry of 'gateNumbers', all in parallel. (A gate listed k times
+ * gets k double sharings, for k values reduced together, see 'reduceDegreeViaKing')
+ * Every party shares random values s_1..s_B, with both degree D and degree 2D polynomials. For each batch of
+ * N such values (one from each party), N - D double sharings are extracted by multiplying with a Vandermonde matrix.
+ * Each r is random and unknown to any D parties, since at least N - D of the s values come from honest parties.
+ */
+void Party::generateDoubleSharings(vector<GateNumber> const& gateNumbers) {
+	const ulong count = gateNumbers.size();
+	const ulong L = N - D;//double sharings extracted per batch
+	const ulong B = (count + L - 1) / L;//number of batches
+	fmpz_mod_poly_t f;
+	fmpz_mod_poly_init(f, FIELD_PRIME);
+	MessagePtr messages[N];
+	for (ulong i = 0; i < N; ++i) {
+		messages[i] = newMsg();
+		messages[i]->setDebugInfo("double sharings : " + to_string(B) + " batch(es)");
+	}
+	for (ulong b = 0; b < B; ++b) {
+		fmpz_randm(value, mu->getRandState(), FIELD_PRIME);
+		for (ulong degree : {D, 2*D}) {
+			mu->sampleUnivariate(f, value, degree);
+			calculatePartyShares(f);
+			for (ulong i = 0; i < N; ++i) {
+				MessagePtr m = newMsg();
+				m->setShare(shares+i);
+				messages[i]->addBatchMessage(m);
+			}
+		}
+	}
+	for (ulong i = 0; i < N; ++i) {
+		channels[i]->send(messages[i]);
+	}
+	fmpz_mod_poly_clear(f);
+
+	interact();
+
+	vector<MessagePtr> received(N);
+	for (ulong i = 0; i < N; ++i) {
+		if (!channels[i]->hasMsg() || channels[i]->recv()->getBatchMessages().size() != 2*B) {
+			throw PceasException("A party fails to participate.");
+		}
+		received[i] = channels[i]->recv();
+	}
+	fmpz_t power;
+	fmpz_init(power);
+	ulong produced = 0;
+	for (ulong b = 0; b < B; ++b) {
+		for (ulong l = 0; l < L && produced < count; ++l, ++produced) {
+			auto& reserved = doubleSharings[gateNumbers[produced]];
+			reserved.emplace_back();
+			DoubleSharing& ds = reserved.back();
+			for (ulong i = 0; i < N; ++i) {
+				//Vandermonde matrix entry M[l][i] = (i+1)^l
+				fmpz_one(power);
+				for (ulong e = 0; e < l; ++e) {
+					fmpz_mul_ui(power, power, i+1);
+					fmpz_mod(power, power, FIELD_PRIME);
+				}
+				fmpz_addmul(ds.rD, power, received[i]->getBatchMessages()[2*b]->getShare());
+				fmpz_addmul(ds.r2D, power, received[i]->getBatchMessages()[2*b+1]->getShare());
+			}
+			fmpz_mod(ds.rD, ds.rD, FIELD_PRIME);
+			fmpz_mod(ds.r2D, ds.r2D, FIELD_PRIME);
+		}
+	}
+	fmpz_clear(power);
+}
+
+/**
+ * Preprocessing for 'CEPS' with Beaver triples
+ * Generates our shares of a random triple (x, y, z = x * y) for each of the MULT gates 'gateNumbers', all in parallel.
+ *  - Every party shares random values, x and y are the sums of them (random as long as a single party is honest).
+ *  - z is computed from local products [x].[y] via degree reduction.
+ * Only the online phase gets cheaper : here, z of each triple still takes a full degree reduction ('reduceDegree').
+ */
+void Party::generateBeaverTriples(vector<GateNumber> const& gateNumbers) {
+	const ulong count = gateNumbers.size();
+	fmpz* xy = _fmpz_vec_init(2*count);//x values followed by y values
+	for (ulong j = 0; j < 2*count; ++j) {
+		fmpz_randm(xy+j, mu->getRandState(), FIELD_PRIME);
+	}
+	distributeShares(xy, 2*count);
+
+	interact();
+
+	_fmpz_vec_zero(xy, 2*count);
+	for (ulong i = 0; i < N; ++i) {
+		if (!channels[i]->hasMsg() || channels[i]->recv()->getBatchMessages().size() != 2*count) {
+			throw PceasException("A party fails to participate.");
+		}
+		auto const& received = channels[i]->recv()->getBatchMessages();
+		for (ulong j = 0; j < 2*count; ++j) {
+			fmpz_add(xy+j, xy+j, received[j]->getShare());
+		}
 	}
-	fmpz_mod_poly_clear(f);
+	fmpz* z = _fmpz_vec_init(count);
+	for (ulong j = 0; j < count; ++j) {
+		fmpz_mod(xy+j, xy+j, FIELD_PRIME);
+		fmpz_mod(xy+count+j, xy+count+j, FIELD_PRIME);
+		fmpz_mul(z+j, xy+j, xy+count+j);
+		fmpz_mod(z+j, z+j, FIELD_PRIME);
+	}
+	reduceDegree(z, count, gateNumbers);//INTERACTIVE
+	beaverTriples.clear();
+	for (ulong j = 0; j < count; ++j) {
+		BeaverTriple& triple = beaverTriples[gateNumbers[j]];
+		fmpz_set(triple.x, xy+j);
+		fmpz_set(triple.y, xy+count+j);
+		fmpz_set(triple.z, z+j);
+	}
+	_fmpz_vec_clear(xy, 2*count);
+	_fmpz_vec_clear(z, count);
 }
 
 /**
@@ -614,67 +1753,124 @@ void Party::distributeVerifiableShares(fmpz_t const& val, string uniqueSuffix, s
  *  - agree that the dealer is dishonest
  */
 void Party::distributeVerifiableShares(CommitmentId cid, string uniqueSuffix, string label, bool preprocessingPhase, bool inputSharingPhase) {
+	distributeVerifiableShares(vector<CommitmentId>(1, cid), vector<string>(1, uniqueSuffix), vector<string>(1, label), preprocessingPhase, inputSharingPhase);
+}
+
+/**
+ * Batched VSS
+ * Distributes committed shares for each of the commitments 'cids' owned by this party, all in the same rounds.
+ * Shares of the j-th commitment of every party are named with 'uniqueSuffixes[j]'. Hence, every party distributes
+ * the same number of commitments. (A party distributing a different number is treated as corrupt.)
+ */
+void Party::distributeVerifiableShares(vector<CommitmentId> const& cids, vector<string> const& uniqueSuffixes, vector<string> const& labels, bool preprocessingPhase, bool inputSharingPhase) {
+	if (uniqueSuffixes.size() != cids.size()) {
+		throw PceasException("Conflicting argument values.");
+	}
+	distributeVerifiableShares(cids, [&uniqueSuffixes](ulong j){return uniqueSuffixes[j];}, labels, preprocessingPhase, inputSharingPhase);
+}
+
+/**
+ * Batched VSS
+ * Shares of the j-th commitment of every party are named with 'uniqueSuffixOf(j)'.
+ * If 'maxCount' is 0, every party distributes the same number of commitments as we do. Otherwise, each party
+ * distributes any number of commitments up to 'maxCount' (possibly none, in which case it only participates).
+ * (A party distributing a number of commitments not allowed is treated as corrupt.)
+ */
+void Party::distributeVerifiableShares(vector<CommitmentId> const& cids, function<string(ulong)> const& uniqueSuffixOf, vector<string> const& labels, bool preprocessingPhase, bool inputSharingPhase, ulong maxCount) {
+	const ulong count = cids.size();
+	if (labels.size() != count || (maxCount != 0 && count > maxCount)) {
+		throw PceasException("Conflicting argument values.");
+	}
+	vector<ulong> counts(N, count);//number of commitments distributed by party p : counts[p-1]
 	{//Step 1
 		commitments->clearVssFlags();
-		CommitmentRecord* cr = commitments->getRecord(cid);
-		if (cr == nullptr || cr->getOwner() != pid) {
-			throw PceasException("Bad commitid : " + cid);
-		}
 		fmpz_mod_poly_t f;
 		fmpz_mod_poly_init(f, FIELD_PRIME);
-		mu->sampleUnivariate(f, cr->getOpenedValue(), D);
-		if (!MathUtil::degreeCheckEQ(f, D)) {
-			throw PceasException("Bad polynomial degree.");
-		}
-		//we commit to all coefficients (except the x^0 coefficient)
-		for (ulong i = 1; i <= D; ++i) {
-			fmpz_mod_poly_get_coeff_fmpz(value, f, i);
-			commit(value, getCoeffCommitIdForSharing(cid, i));
-		}
-		fmpz_mod_poly_clear(f);
+		fmpz* coeffs = _fmpz_vec_init(D*count);
+		vector<CommitmentId> coeffIds;
 		//Let other parties know about the VSS we intend to perform
 		MessagePtr bm = newMsg();
-		bm->setCommitId(cid);
-		if (label != NONE) {
-			bm->setInput(label);
+		for (ulong j = 0; j < count; ++j) {
+			CommitmentRecord* cr = commitments->getRecord(cids[j]);
+			if (cr == nullptr || cr->getOwner() != pid) {
+				throw PceasException("Bad commitid : " + cids[j]);
+			}
+			mu->sampleUnivariate(f, cr->getOpenedValue(), D);
+			if (!MathUtil::degreeCheckEQ(f, D)) {
+				throw PceasException("Bad polynomial degree.");
+			}
+			//we commit to all coefficients (except the x^0 coefficient)
+			for (ulong i = 1; i <= D; ++i) {
+				fmpz_mod_poly_get_coeff_fmpz(coeffs+coeffIds.size(), f, i);
+				coeffIds.push_back(getCoeffCommitIdForSharing(cids[j], i));
+			}
+			MessagePtr m = newMsg();
+			m->setCommitId(cids[j]);
+			if (labels[j] != NONE) {
+				m->setInput(labels[j]);
+			}
+			bm->addBatchMessage(m);
+		}
+		commit(coeffs, coeffIds.size(), coeffIds);//INTERACTIVE
+		_fmpz_vec_clear(coeffs, D*count);
+		fmpz_mod_poly_clear(f);
+		if (count > 0) {//(with nothing to distribute, we broadcast nothing, see Step 2)
+			broadcast->broadcast(bm);
 		}
-		broadcast->broadcast(bm);
 	}
 
 	interact();
 
-	CommitmentId shares[N][N];
-	string labels[N];
+	vector<CommitmentId> shares;//share for party k of the j-th VSS by party p : shares[(j*N + p-1)*N + k-1]
+	vector<string> labelsReceived;//label of the j-th VSS by party p : labelsReceived[j*N + p-1]
+	ulong maxReceived;//largest number of commitments distributed by a single party
 	{//Step 2
 		vector<MessagePtr> vssMessages;
 		for (ulong i = 0; i < N; ++i) {
 		PartyId p = i + 1;
+			if (maxCount != 0) {
+				counts[i] = 0;//(unless the broadcast of the party is accepted)
+			}
 			if (broadcast->hasMsg(p)) {
 				MessagePtr m = broadcast->recv(p);
-				CommitmentRecord* cri = commitments->getRecord(m->getCommitId());
-				if (cri == nullptr || cri->getOwner() != m->getSender()) {
-					addCorrupt(p);
-				} else {
+				const ulong received = m->getBatchMessages().size();
+				bool ok = (maxCount == 0) ? (received == count) : (received <= maxCount);
+				for (auto const& vss : m->getBatchMessages()) {
+					CommitmentRecord* cri = commitments->getRecord(vss->getCommitId());
+					if (cri == nullptr || cri->getOwner() != m->getSender()) {
+						ok = false;
+					}
+				}
+				if (ok) {
 					vssMessages.push_back(m);
+					counts[i] = received;
+				} else {
+					addCorrupt(p);
 				}
-			} else {
+			} else if (maxCount == 0 && count > 0) {//(a missing broadcast declares no commitments)
 				addCorrupt(p);//every honest party must provide its share.
 			}
 		}
+		maxReceived = *max_element(counts.begin(), counts.end());
+		shares.resize(maxReceived*N*N);
+		labelsReceived.resize(maxReceived*N);
 		/*
 		 * At this stage every coefficient is committed to, and every party can locally form commitments
 		 * to <f(k)> = cid + Ʃ ( k^i . <cid_coeff_i> ) using 'add' and 'scalarMult'.
 		 */
-		for (auto const& vss : vssMessages) {
-			for (ulong i = 0; i < N; ++i) {
-				PartyId k = i+1;
-				CommitmentId share = combineCoeffCommitsForSharing(vss->getCommitId(), k);
-				shares[vss->getSender()-1][i] = share;
-			}
-			if (inputSharingPhase && vss->isInput()) {
-				labels[vss->getSender()-1] = vss->getInputLabel();
-			} else {
-				labels[vss->getSender()-1] = NONE;
+		for (auto const& m : vssMessages) {
+			const PartyId p = m->getSender();
+			for (ulong j = 0; j < counts[p-1]; ++j) {
+				MessagePtr const& vss = m->getBatchMessages()[j];
+				for (ulong i = 0; i < N; ++i) {
+					PartyId k = i+1;
+					shares[(j*N + p-1)*N + i] = combineCoeffCommitsForSharing(vss->getCommitId(), k);
+				}
+				if (inputSharingPhase && vss->isInput()) {
+					labelsReceived[j*N + p-1] = vss->getInputLabel();
+				} else {
+					labelsReceived[j*N + p-1] = NONE;
+				}
 			}
 		}
 	}
@@ -682,13 +1878,18 @@ void Party::distributeVerifiableShares(CommitmentId cid, string uniqueSuffix, st
 		/*
 		 * Now we distribute our shares to the corresponding parties via 'transferCommit's.
 		 * Note that each party is running a 'distributeCommittedShares'.
-		 * In order to be able to run the 'transferCommit's in parallel,
-		 * each party must be targeted at most once per iteration. (See 'getTargetForIteration')
+		 * Shares of all our commitments for all other parties are transfered together, in a single
+		 * batched 'transferCommit'. (We don't transfer to self.)
 		 */
-		for (ulong i = 1; i < N; ++i) {//we start from i = 1, so that we don't transfer to self
-			PartyId k = getTargetForIteration(i);
-			transferCommitment(shares[pid-1][k-1], k);
+		vector< pair<CommitmentId, PartyId> > toTransfer;
+		for (PartyId k = 1; k <= N; ++k) {
+			if (k != pid) {
+				for (ulong j = 0; j < count; ++j) {
+					toTransfer.push_back(make_pair(shares[(j*N + pid-1)*N + k-1], k));
+				}
+			}
 		}
+		transferCommitment(toTransfer);//INTERACTIVE
 
 		/*
 		 * Both for corrupt and honest, we use vss flag to locate shares.
@@ -696,49 +1897,55 @@ void Party::distributeVerifiableShares(CommitmentId cid, string uniqueSuffix, st
 		 * Each party maintains a list of corrupt parties, in such a way that every
 		 * honest party agrees on this list at all times.
 		 */
-		for (ulong p = 1; p <= N; ++p) {//p:distributer of shares
-			for (ulong k = 1; k <= N; ++k) {//k:receiver of shares
-				if (isCorrupt(p)) {
-					/*
-					 * We use shares of 0, instead of shares distrubuted by parties
-					 * who turned out to be corrupt. With shares of 0,
-					 * they are effectively excluded from recombination.
-					 */
-					CommitmentRecord* zeroRecord = zeroShareFor(k, makeShareName(p, k, uniqueSuffix, inputSharingPhase, preprocessingPhase));
-					zeroRecord->setVss(true);
-					zeroRecord->setPermanent();
-					zeroRecord->setDistributer(p);
-					zeroRecord->setShareNameSuffix(uniqueSuffix);
-					zeroRecord->setMulTriple(preprocessingPhase);
-					/*
-					 * Note : We are making a choice here. If an input provider is identified as corrupt,
-					 * we can either :
-					 *  - Set zero as input and continue
-					 *  OR
-					 *  - Not mark the record as input, in which case execution will stop because we won't have enough
-					 *  inputs.
-					 * For some functions, it might make sense to assume value 0 for missing inputs and continue.
-					 * Here we choose the second option.
-					 */
-//					zeroRecord->setInput();
-				} else {
-					CommitmentId shareId;
-					if (k == p) {
-						shareId = shares[k-1][k-1]; // not transfered to self
+		for (ulong j = 0; j < maxReceived; ++j) {
+			const string uniqueSuffix = uniqueSuffixOf(j);
+			for (ulong p = 1; p <= N; ++p) {//p:distributer of shares
+				if (j >= counts[p-1]) {
+					continue;//party p distributed fewer commitments
+				}
+				for (ulong k = 1; k <= N; ++k) {//k:receiver of shares
+					if (isCorrupt(p)) {
+						/*
+						 * We use shares of 0, instead of shares distrubuted by parties
+						 * who turned out to be corrupt. With shares of 0,
+						 * they are effectively excluded from recombination.
+						 */
+						CommitmentRecord* zeroRecord = zeroShareFor(k, makeShareName(p, k, uniqueSuffix, inputSharingPhase, preprocessingPhase));
+						zeroRecord->setVss(true);
+						zeroRecord->setPermanent();
+						zeroRecord->setDistributer(p);
+						zeroRecord->setShareNameSuffix(uniqueSuffix);
+						zeroRecord->setMulTriple(preprocessingPhase);
+						/*
+						 * Note : We are making a choice here. If an input provider is identified as corrupt,
+						 * we can either :
+						 *  - Set zero as input and continue
+						 *  OR
+						 *  - Not mark the record as input, in which case execution will stop because we won't have enough
+						 *  inputs.
+						 * For some functions, it might make sense to assume value 0 for missing inputs and continue.
+						 * Here we choose the second option.
+						 */
+//						zeroRecord->setInput();
 					} else {
-						shareId = getTransferedCommitId(shares[p-1][k-1], p, k);
-					}
-					string inputLabel = labels[p-1];
-					CommitmentRecord* crShare = commitments->getRecord(shareId);
-					commitments->rename(shareId, makeShareName(p, k, uniqueSuffix, inputSharingPhase, preprocessingPhase));
-					crShare->setVss(true);
-					crShare->setPermanent();
-					crShare->setDistributer(p);
-					crShare->setShareNameSuffix(uniqueSuffix);
-					if (inputLabel != NONE) {
-						crShare->setInput(inputLabel);
+						CommitmentId shareId;
+						if (k == p) {
+							shareId = shares[(j*N + k-1)*N + k-1]; // not transfered to self
+						} else {
+							shareId = getTransferedCommitId(shares[(j*N + p-1)*N + k-1], p, k);
+						}
+						string inputLabel = labelsReceived[j*N + p-1];
+						CommitmentRecord* crShare = commitments->getRecord(shareId);
+						commitments->rename(shareId, makeShareName(p, k, uniqueSuffix, inputSharingPhase, preprocessingPhase));
+						crShare->setVss(true);
+						crShare->setPermanent();
+						crShare->setDistributer(p);
+						crShare->setShareNameSuffix(uniqueSuffix);
+						if (inputLabel != NONE) {
+							crShare->setInput(inputLabel);
+						}
+						crShare->setMulTriple(preprocessingPhase);
 					}
-					crShare->setMulTriple(preprocessingPhase);
 				}
 			}
 		}
@@ -749,35 +1956,90 @@ void Party::distributeVerifiableShares(CommitmentId cid, string uniqueSuffix, st
 /**
  * We produce a degree D Shamir share, via degree reduction, by recombining local shares for a degree 2D polynomial
  * Note : During recombination of commitments, both values and polynomials fx_0 get dotted.
- * Note : To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
+ * Returned recipe is the same for all parties (see 'mirrorGateResult').
  */
-CommitmentId Party::runDegreeReduction(vector<CommitmentRecord*> const& shares, GateNumber gn) {
-	CommitmentId result; // our reduced share
-	for (PartyId k = 1; k <= N; ++k) {
-		CommitmentId combined_k = NONE;
-		for (auto const& record : shares) {
-			ulong arrIndex = record->getDistributer() - 1;
-			fmpz_set(value, recombinationVector+arrIndex);
-			const CommitmentId share_k = getShareNameFor(k, record->getCommitid());
-			CommitmentId term_k = constMultCommitment(value, share_k);
-			if (combined_k == NONE) {
-				combined_k = term_k;
-			} else {
-				combined_k = addCommitments(combined_k, term_k);
-			}
-		}
-		CommitmentId result_k = makeShareName(NOPARTY, k, to_string(gn), false, false, true);
-		commitments->rename(combined_k, result_k);
-		CommitmentRecord* cr_k = commitments->getRecord(result_k);
-		if (cr_k == nullptr || cr_k->getOwner() != k) {//should not happen
-			throw PceasException("Invalid commitment.");
-		}
-		cr_k->setPermanent();
-		if (k == pid) {
-			result = cr_k->getCommitid();
+Party::GateRecipe Party::runDegreeReduction(vector<CommitmentRecord*> const& shares) const {
+	GateRecipe recipe;
+	for (auto const& record : shares) {
+		ulong arrIndex = record->getDistributer() - 1;
+		recipe.coeffs.push_back(reduce(recombinationVector+arrIndex));
+		recipe.operands.push_back(record->getCommitid());
+	}
+	return recipe;
+}
+
+/**
+ * Assigns output of gate 'g' (for us, and for other parties).
+ * To keep the commitment records synchronized, we do all other parties local computations, in addition to our own.
+ * With on-demand mirroring, we only store the recipes for other parties, and records for their shares of gate output
+ * are derived when they are first looked up (when an open, transfer or dispute needs them, see 'deriveMirroredRecord').
+ * Recipes are fixed at the time gate is processed, so all honest derive the same records.
+ */
+void Party::mirrorGateResult(Gate* g, function<GateRecipe(PartyId)> const& recipeFor) {
+	const GateNumber gn = g->getGateNumber();
+	if (onDemandMirroring) {
+		deferredMirrors[gn] = recipeFor;
+		assignGateResult(pid, gn, recipeFor(pid));
+	} else {
+		for (PartyId k = 1; k <= N; ++k) {
+			assignGateResult(k, gn, recipeFor(k));
 		}
 	}
-	return result;
+	CommitmentId result = makeShareName(NOPARTY, pid, to_string(gn), false, false, true);
+	g->assignResult(result);
+#ifdef VERBOSE
+	cout << "Party " << to_string(pid) << " assigns output to gate# " << gn << " : \nCID = "
+		 << result << "\nOpenedValue = " << MathUtil::fmpzToStr(commitments->getRecord(result)->getOpenedValue()) << endl;
+#endif
+}
+
+/**
+ * Party k's share of gate output is computed as <Ʃ c_i . operand_i + constant>, using party k's commitments.
+ */
+CommitmentId Party::assignGateResult(PartyId k, GateNumber gn, GateRecipe const& recipe) {
+	vector<CommitmentId> operands_k;
+	fmpz* coeffs = _fmpz_vec_init(recipe.operands.size());
+	for (ulong i = 0; i < recipe.operands.size(); ++i) {
+		operands_k.push_back(getShareNameFor(k, recipe.operands[i]));
+		fmpz_set_ui(coeffs+i, recipe.coeffs[i]);
+	}
+	const CommitmentId result_k = makeShareName(NOPARTY, k, to_string(gn), false, false, true);
+	linearCombineCommitments(coeffs, operands_k, result_k, recipe.constant);
+	_fmpz_vec_clear(coeffs, recipe.operands.size());
+	CommitmentRecord* cr_k = commitments->getRecord(result_k);
+	if (cr_k == nullptr || cr_k->getOwner() != k) {//should not happen
+		throw PceasException("Wire is assigned invalid commitment.");
+	}
+	cr_k->setPermanent();
+	return result_k;
+}
+
+/**
+ * Called by the commitment table when a record is not found.
+ * If 'cid' names another party's share of a gate output, which we have not computed yet, we compute it now.
+ */
+void Party::deriveMirroredRecord(CommitmentId cid) {
+	const string prefix = SHARE_PREFIX + "(assigned)";
+	if (cid.compare(0, prefix.size(), prefix) != 0) {
+		return;
+	}
+	PartyId k;
+	GateNumber gn;
+	try {
+		auto const& tokens = splitShareName(cid);
+		k = stoul(tokens.at(2));
+		gn = stoul(tokens.at(3));
+	} catch (PceasException& e) {//malformed name. (IDs received from other parties can be anything.)
+		return;
+	} catch (logic_error& e) {//malformed number
+		return;
+	}
+	auto it = deferredMirrors.find(gn);
+	if (it == deferredMirrors.end() || k == pid || k < 1 || k > N
+			|| cid != makeShareName(NOPARTY, k, to_string(gn), false, false, true)) {
+		return;//not a name we would generate
+	}
+	assignGateResult(k, gn, it->second(k));
 }
 
 /**
@@ -785,18 +2047,17 @@ CommitmentId Party::runDegreeReduction(vector<CommitmentRecord*> const& shares,
  */
 CommitmentId Party::sumShares(vector<CommitmentRecord*> const& shares, GateNumber gn, const char* multiplicandId) {
 	CommitmentId result; // our reduced share
+	fmpz* ones = _fmpz_vec_init(shares.size());
+	for (ulong i = 0; i < shares.size(); ++i) {
+		fmpz_one(ones+i);
+	}
 	for (PartyId k = 1; k <= N; ++k) {
-		CommitmentId combined_k = NONE;
+		vector<CommitmentId> shares_k;
 		for (auto const& record : shares) {
-			const CommitmentId share_k = getShareNameFor(k, record->getCommitid());
-			if (combined_k == NONE) {
-				combined_k = share_k;
-			} else {
-				combined_k = addCommitments(combined_k, share_k);
-			}
+			shares_k.push_back(getShareNameFor(k, record->getCommitid()));
 		}
 		CommitmentId result_k = makeTripleName(k, multiplicandId, gn);
-		commitments->rename(combined_k, result_k);
+		linearCombineCommitments(ones, shares_k, result_k);
 		CommitmentRecord* cr_k = commitments->getRecord(result_k);
 		if (cr_k == nullptr || cr_k->getOwner() != k) {//should not happen
 			throw PceasException("Invalid commitment.");
@@ -806,66 +2067,95 @@ CommitmentId Party::sumShares(vector<CommitmentRecord*> const& shares, GateNumbe
 			result = cr_k->getCommitid();
 		}
 	}
+	_fmpz_vec_clear(ones, shares.size());
 	return result;
 }
 
 /**
- * Generates “sufficiently many” multiplication triples.
- * Ideally, we would want to generate our triples in a parallel fashion. Different approaches exist for triple generation.
- * Below, we process triples one at a time, which sort of nullifies any overall gain we expect to get from
- * using circuit randomization. For us, it still makes sense to do it this way, because we aim to observe the
- * reduction in number of rounds for step 2, circuit evaluation.
+ * Provides “sufficiently many” multiplication triples.
  *
  * For convenience of implementation, instead of making a guess for “sufficiently many”, we count multiplicaton gates
- * in the circuit. However we note that, normally preprocessing phase is independent of the circuit to be evaluated.
+ * in the circuit. However we note that, normally preprocessing phase is independent of the circuit to be evaluated :
+ * triples can be generated ahead of time (see 'runOfflinePreprocessing'), in which case they are loaded from the stockpile.
  */
 void Party::runPreprocessing() {
+	vector<GateNumber> gateNumbers;//all parties process triples in the same order
 	for (auto const& g : circuit->getGates()) {
-		if (g->getType() == MULT) {
-			MultiplicationTriple triple;
-			triples.insert(pair<GateNumber, MultiplicationTriple>(g->getGateNumber(), triple));
+		if (g->getType() == MULT && !g->isProcessed()) {//(in an incremental run, results of clean gates are kept)
+			gateNumbers.push_back(g->getGateNumber());
 		}
 	}
-	const auto TRIPLE_COUNT = triples.size();
+	sort(gateNumbers.begin(), gateNumbers.end());
+	if (tripleStockpile.empty()) {
+		generateTriples(gateNumbers);
+	} else {
+		loadTripleStockpile(gateNumbers);
+	}
+}
+
+/**
+ * Generates a multiplication triple for each of the given keys (gate numbers).
+ * Triples are generated in parallel : randoms for all triples are shared in a single batched VSS,
+ * all products are computed with a single batched commitment multiplication, and shared in a single batched VSS.
+ * Hence the number of rounds for preprocessing does not depend on the number of triples.
+ */
+void Party::generateTriples(vector<GateNumber> const& gateNumbers) {
+	for (auto const& gn : gateNumbers) {
+		triples.insert(pair<GateNumber, MultiplicationTriple>(gn, MultiplicationTriple()));
+	}
+	const auto TRIPLE_COUNT = gateNumbers.size();
+	if (TRIPLE_COUNT == 0) {
+		return;
+	}
 	//we need 2 * TRIPLE_COUNT randoms as x and y values
 	fmpz_zero(value);
 	fmpz_mod_poly_t randoms;
 	fmpz_mod_poly_init(randoms, FIELD_PRIME);
 	fmpz_mod_poly_zero(randoms);
 	mu->sampleUnivariate(randoms, value, 2*TRIPLE_COUNT);
-	ulong coeffCounter = 1;
-	for (auto& t : triples) {
-		fmpz_t x,y;
-		fmpz_init_set_ui(x, 0);
-		fmpz_init_set_ui(y, 0);
-
-		/*
-		 * Note :
-		 *  - ('maxDishonest' + 1) individual randoms would be enough for the linear combination(in this case, sum)
-		 *  to be random. Not every party would have to share a value.
-		 */
-		fmpz_mod_poly_get_coeff_fmpz(x, randoms, coeffCounter++);
-		fmpz_mod_poly_get_coeff_fmpz(y, randoms, coeffCounter++);
-		//Each party D-shares its random (for each multiplicand)
-		distributeVerifiableShares(x, to_string(t.first)+MultiplicationTriple::M1, NONE, true); // INTERACTIVE.
-		vector<CommitmentRecord*> receivedSharesM1 = commitments->getVSSharesReceivedBy(pid);
-		distributeVerifiableShares(y, to_string(t.first)+MultiplicationTriple::M2, NONE, true); // INTERACTIVE.
-		vector<CommitmentRecord*> receivedSharesM2 = commitments->getVSSharesReceivedBy(pid);
-		/*
-		 * Sum over shares of individual randoms to obtain a share for a single random.
-		 * Notes:
-		 *  - As long as one party is honest, sum will be random. No party will know this random value.
-		 *  - We did not have to do a summation, any linear combination would do.
-		 */
-		CommitmentId idMult1 = sumShares(receivedSharesM1, t.first, MultiplicationTriple::M1);
-		CommitmentId idMult2 = sumShares(receivedSharesM2, t.first, MultiplicationTriple::M2);
+	/*
+	 * Note :
+	 *  - ('maxDishonest' + 1) individual randoms would be enough for the linear combination(in this case, sum)
+	 *  to be random. Not every party would have to share a value.
+	 */
+	fmpz* xy = _fmpz_vec_init(2*TRIPLE_COUNT);
+	vector<string> suffixes;
+	for (ulong j = 0; j < TRIPLE_COUNT; ++j) {
+		fmpz_mod_poly_get_coeff_fmpz(xy+2*j, randoms, 2*j+1);
+		fmpz_mod_poly_get_coeff_fmpz(xy+2*j+1, randoms, 2*j+2);
+		suffixes.push_back(to_string(gateNumbers[j])+MultiplicationTriple::M1);
+		suffixes.push_back(to_string(gateNumbers[j])+MultiplicationTriple::M2);
+	}
+	//Each party D-shares its randoms (for each multiplicand of each triple)
+	vector<CommitmentId> xyIds = commit(xy, 2*TRIPLE_COUNT); // INTERACTIVE.
+	distributeVerifiableShares(xyIds, suffixes, vector<string>(2*TRIPLE_COUNT, NONE), true); // INTERACTIVE.
+	_fmpz_vec_clear(xy, 2*TRIPLE_COUNT);
+	fmpz_mod_poly_clear(randoms);
+	/*
+	 * Sum over shares of individual randoms to obtain a share for a single random.
+	 * Notes:
+	 *  - As long as one party is honest, sum will be random. No party will know this random value.
+	 *  - We did not have to do a summation, any linear combination would do.
+	 */
+	vector< pair<CommitmentId, CommitmentId> > multiplicands;
+	for (ulong j = 0; j < TRIPLE_COUNT; ++j) {
+		CommitmentId idMult1 = sumShares(commitments->getVSSharesReceivedBy(pid, suffixes[2*j]), gateNumbers[j], MultiplicationTriple::M1);
+		CommitmentId idMult2 = sumShares(commitments->getVSSharesReceivedBy(pid, suffixes[2*j+1]), gateNumbers[j], MultiplicationTriple::M2);
+		multiplicands.push_back(make_pair(idMult1, idMult2));
+	}
 
-		CommitmentId product = multiplyCommitments(idMult1, idMult2); // INTERACTIVE.
-		distributeVerifiableShares(product, to_string(t.first), NONE, true); // INTERACTIVE.
-		t.second.receivedShares = commitments->getVSSharesReceivedBy(pid);
+	vector<CommitmentId> products = multiplyCommitments(multiplicands); // INTERACTIVE.
+	vector<string> productSuffixes;
+	for (auto const& gn : gateNumbers) {
+		productSuffixes.push_back(to_string(gn));
+	}
+	distributeVerifiableShares(products, productSuffixes, vector<string>(TRIPLE_COUNT, NONE), true); // INTERACTIVE.
+	for (auto const& gn : gateNumbers) {
+		MultiplicationTriple& triple = triples[gn];
+		triple.receivedShares = commitments->getVSSharesReceivedBy(pid, to_string(gn));
 		for (PartyId k = 1; k <= N; ++k) {//set triples from all parties as permanent
-			CommitmentId idMult1_k = makeTripleName(k, MultiplicationTriple::M1, t.first);
-			CommitmentId idMult2_k = makeTripleName(k, MultiplicationTriple::M2, t.first);
+			CommitmentId idMult1_k = makeTripleName(k, MultiplicationTriple::M1, gn);
+			CommitmentId idMult2_k = makeTripleName(k, MultiplicationTriple::M2, gn);
 			CommitmentId product_k = getMultipliedCommitId(idMult1_k, idMult2_k);
 			CommitmentRecord* crFirst_k = commitments->getRecord(idMult1_k);
 			CommitmentRecord* crSecond_k = commitments->getRecord(idMult2_k);
@@ -881,19 +2171,153 @@ void Party::runPreprocessing() {
 			crSecond_k->setPermanent();
 			crProd_k->setPermanent();
 			if (k == pid) {
-				t.second.firstMult = crFirst_k;
-				t.second.secontMult = crSecond_k;
-				t.second.product = crProd_k;
+				triple.firstMult = crFirst_k;
+				triple.secontMult = crSecond_k;
+				triple.product = crProd_k;
 #ifdef VERBOSE
 				this_thread::sleep_for(chrono::milliseconds(pid*700));
-				cout << "Preprocessing for gate " << to_string(t.first) << " Party : " << to_string(pid) << ", Triple (M1, M2, PROD) : " <<  MathUtil::fmpzToStr(crFirst_k->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(crSecond_k->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(crProd_k->getOpenedValue()) << endl;
+				cout << "Preprocessing for gate " << to_string(gn) << " Party : " << to_string(pid) << ", Triple (M1, M2, PROD) : " <<  MathUtil::fmpzToStr(crFirst_k->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(crSecond_k->getOpenedValue()) << "\t" << MathUtil::fmpzToStr(crProd_k->getOpenedValue()) << endl;
 #endif
 			}
 		}
-		fmpz_clear(x);
-		fmpz_clear(y);
 	}
-	fmpz_mod_poly_clear(randoms);
+}
+
+/**
+ * Offline mode of 'CEAS with Circuit Randomization' : generates 'offlineTripleCount' multiplication triples,
+ * independent of any circuit, and saves them to the triple stockpile.
+ * Later (online) runs load triples from the stockpile instead of running preprocessing (see 'loadTripleStockpile').
+ */
+void Party::runOfflinePreprocessing() {
+	sanityChecks();
+	setRecombinationVector();
+	vector<GateNumber> slots;//until they are assigned to gates, triples are keyed by their position in the stockpile
+	for (ulong i = 0; i < offlineTripleCount; ++i) {
+		slots.push_back(i);
+	}
+	generateTriples(slots);
+	commitments->cleanUp();
+	reportStatistics("preprocessing");
+	saveTripleStockpile(slots);
+	end();
+}
+
+/**
+ * Names of the records making up the triple for gate 'gn', as seen by us :
+ * x, y and x * y of each party, followed by the shares of x * y each party received from each party.
+ */
+vector<CommitmentId> Party::getTripleRecordNames(GateNumber gn) const {
+	vector<CommitmentId> names;
+	for (PartyId k = 1; k <= N; ++k) {
+		const CommitmentId idMult1_k = makeTripleName(k, MultiplicationTriple::M1, gn);
+		const CommitmentId idMult2_k = makeTripleName(k, MultiplicationTriple::M2, gn);
+		names.push_back(idMult1_k);
+		names.push_back(idMult2_k);
+		names.push_back(getMultipliedCommitId(idMult1_k, idMult2_k));
+	}
+	for (PartyId p = 1; p <= N; ++p) {//p:distributer of shares
+		for (PartyId k = 1; k <= N; ++k) {//k:receiver of shares
+			names.push_back(makeShareName(p, k, to_string(gn), false, true));
+		}
+	}
+	return names;
+}
+
+/**
+ * Triple stockpile format (binary, one file per party) :
+ *  - pid, N, D, p and the set of parties known to be corrupt. (The stockpile can only be used by the same party, in the same setting)
+ *  - Number of triples, followed by the triples. Each triple is a list of records (see 'getTripleRecordNames'),
+ *    each preceded by a flag telling whether the record exists. (Records of parties found corrupt during preprocessing may not)
+ * Record names are not stored; they are derived from the gate number a triple gets assigned to, when it is loaded.
+ */
+void Party::writeTripleStockpileHeader(ostream& os, ulong tripleCount) const {
+	MathUtil::writeUlong(os, TRIPLE_STOCKPILE_MAGIC);
+	MathUtil::writeUlong(os, pid);
+	MathUtil::writeUlong(os, N);
+	MathUtil::writeUlong(os, D);
+	MathUtil::writeFmpz(os, FIELD_PRIME);
+	MathUtil::writeUlong(os, corrupted.size());
+	for (auto const& p : corrupted) {
+		MathUtil::writeUlong(os, p);
+	}
+	MathUtil::writeUlong(os, tripleCount);
+}
+
+void Party::saveTripleStockpile(vector<GateNumber> const& gateNumbers) {
+	ofstream os(tripleStockpile, ios::binary | ios::trunc);
+	if (!os.is_open()) {
+		throw runtime_error("Could not open triple stockpile : "+tripleStockpile);
+	}
+	writeTripleStockpileHeader(os, gateNumbers.size());
+	for (auto const& gn : gateNumbers) {
+		for (auto const& name : getTripleRecordNames(gn)) {
+			CommitmentRecord* cr = commitments->getRecord(name);
+			MathUtil::writeUlong(os, cr != nullptr);
+			if (cr != nullptr) {
+				cr->save(os);
+			}
+		}
+	}
+}
+
+/**
+ * Takes a triple from the stockpile for each of the given gates. Taken triples are removed from the stockpile,
+ * so that a triple is never used twice. All honest parties take the same triples, since their stockpiles were
+ * produced by the same offline run, and consumed by the same sequence of online runs.
+ */
+void Party::loadTripleStockpile(vector<GateNumber> const& gateNumbers) {
+	ifstream is(tripleStockpile, ios::binary);
+	if (!is.is_open()) {
+		throw runtime_error("Could not open triple stockpile : "+tripleStockpile);
+	}
+	if (MathUtil::readUlong(is) != TRIPLE_STOCKPILE_MAGIC || MathUtil::readUlong(is) != pid || MathUtil::readUlong(is) != N
+			|| MathUtil::readUlong(is) != D || MathUtil::readUlong(is) != fmpz_get_ui(FIELD_PRIME)) {
+		throw runtime_error("Triple stockpile does not match the setting : "+tripleStockpile);
+	}
+	const ulong corruptCount = MathUtil::readUlong(is);
+	for (ulong i = 0; i < corruptCount; ++i) {//parties found corrupt while generating triples remain excluded
+		const PartyId p = MathUtil::readUlong(is);
+		if (!isCorrupt(p)) {
+			addCorrupt(p);
+		}
+	}
+	const ulong tripleCount = MathUtil::readUlong(is);
+	if (tripleCount < gateNumbers.size()) {
+		throw runtime_error("Not enough multiplication triples in stockpile : "+tripleStockpile);
+	}
+	for (auto const& gn : gateNumbers) {
+		auto const& names = getTripleRecordNames(gn);
+		for (ulong i = 0; i < names.size(); ++i) {
+			if (MathUtil::readUlong(is) == 0) {
+				continue;
+			}
+			CommitmentRecord* cr = new CommitmentRecord(NOPARTY, FIELD_PRIME, pid);
+			cr->load(is);
+			cr->setCommitid(names[i]);
+			if (i >= 3*N) {//shares of x * y
+				cr->setVss(true);
+				cr->setShareNameSuffix(to_string(gn));
+			}
+			commitments->addRecord(cr);
+		}
+		const CommitmentId idMult1 = makeTripleName(pid, MultiplicationTriple::M1, gn);
+		const CommitmentId idMult2 = makeTripleName(pid, MultiplicationTriple::M2, gn);
+		MultiplicationTriple triple;
+		triple.firstMult = commitments->getRecord(idMult1);
+		triple.secontMult = commitments->getRecord(idMult2);
+		triple.product = commitments->getRecord(getMultipliedCommitId(idMult1, idMult2));
+		triple.receivedShares = commitments->getVSSharesReceivedBy(pid, to_string(gn));
+		triples.insert(pair<GateNumber, MultiplicationTriple>(gn, triple));
+	}
+	//write back the triples we did not take
+	const string remaining((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+	is.close();
+	ofstream os(tripleStockpile, ios::binary | ios::trunc);
+	if (!os.is_open()) {
+		throw runtime_error("Could not open triple stockpile : "+tripleStockpile);
+	}
+	writeTripleStockpileHeader(os, tripleCount - gateNumbers.size());
+	os << remaining;
 }
 
 /**
@@ -911,33 +2335,70 @@ CommitmentRecord* Party::zeroShareFor(PartyId id, CommitmentId cid) {
  * Party k commits to value 'val'
  */
 CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId) {
-	CommitmentId commitid;
-	SymmBivariatePoly f(FIELD_PRIME, D, pid);
+	return commit(val, 1, vector<CommitmentId>(1, predeterminedCommitId)).front();
+}
+
+/**
+ * Party k commits to 'count' values in a single run of the commitment protocol.
+ * All bivariate sharings and consistency checks of the batch take place in the same rounds,
+ * so the number of rounds does not depend on the batch size. Other parties may commit to batches
+ * of different sizes in the same run.
+ * Disputes and opened verifiable shares are per commitment, but an accusation is against the owner,
+ * hence applies to all of her commitments in the batch.
+ * 'predeterminedCommitIds' is either empty, or holds an ID (possibly NONE) for each value.
+ */
+vector<CommitmentId> Party::commit(fmpz const* vals, ulong count, vector<CommitmentId> const& predeterminedCommitIds) {
+	if (!predeterminedCommitIds.empty() && predeterminedCommitIds.size() != count) {
+		throw PceasException("Commitment IDs do not match the batch.");
+	}
+	vector<CommitmentId> commitids;
+	vector<unique_ptr<SymmBivariatePoly>> polys;
 	{//Step 1
-		//Prepare and privately send verifiable shares to other parties (for our own commitment)
-		if (predeterminedCommitId == NONE) {
-			commitid = commitments->addRecord(pid);
-		} else {//create with supplied commitid. This might happen, for example, during transferCommit, when creating commitments for coefficients of the sampled polynomial
-			commitid = commitments->addRecord(pid, predeterminedCommitId);
-		}
-		CommitmentRecord* commitRecord = commitments->getRecord(commitid);
-		f.sampleBivariate(val, mu->getRandState());
+		//Prepare and privately send verifiable shares to other parties (for our own commitments)
+		MessagePtr messages[N];
 		for (ulong i = 0; i < N; ++i) {
-			fmpz_mod_poly_t fk_x;
-			fmpz_mod_poly_init(fk_x, FIELD_PRIME);
-			MessagePtr m = newMsg();
-			m->setDebugInfo("Commit step 1");
-			f.evaluate(fk_x, i+1);
-			m->setCommitId(commitid);
-			m->setVerifiableShare(fk_x);//send f(x,j) to Party j
-			channels[i]->send(m);
-			fmpz_mod_poly_clear(fk_x);
+			messages[i] = newMsg();
+			messages[i]->setDebugInfo("Commit step 1");
+		}
+		fmpz_mod_poly_t fk_x;
+		fmpz_mod_poly_init(fk_x, FIELD_PRIME);
+		for (ulong j = 0; j < count; ++j) {
+			CommitmentId commitid;
+			if (predeterminedCommitIds.empty() || predeterminedCommitIds[j] == NONE) {
+				commitid = commitments->addRecord(pid);
+			} else {//create with supplied commitid. This might happen, for example, during transferCommit, when creating commitments for coefficients of the sampled polynomial
+				commitid = commitments->addRecord(pid, predeterminedCommitIds[j]);
+			}
+			CommitmentRecord* commitRecord = commitments->getRecord(commitid);
+			polys.emplace_back(new SymmBivariatePoly(FIELD_PRIME, D, pid));
+			SymmBivariatePoly& f = *polys.back();
+			fmpz_set(value, vals+j);
+			f.sampleBivariate(value, mu->getRandState());
+			for (ulong i = 0; i < N; ++i) {
+				MessagePtr m = newMsg();
+				f.evaluate(fk_x, i+1);
+				m->setCommitId(commitid);
+				m->setVerifiableShare(fk_x);//send f(x,j) to Party j
+				messages[i]->addBatchMessage(m);
+			}
+			f.evaluateAtZero(poly);
+			commitRecord->setfx_0(poly);//Will be used to open a commit (assuming the commit succeeds)
+			commitRecord->setOpenedValue(calculateZeroShare(commitRecord->getfx_0()));//we also save f(0,0) to avoid calculating it from fx_0 every time
+			commitids.push_back(commitid);
+		}
+		fmpz_mod_poly_clear(fk_x);
+		if (count > 0) {//(with nothing to commit to, we send nothing. Others treat a missing message as no commitments from us)
+			for (ulong i = 0; i < N; ++i) {
+				channels[i]->send(messages[i]);
+			}
 		}
-		f.evaluateAtZero(poly);
-		commitRecord->setfx_0(poly);//Will be used to open a commit (assuming the commit succeeds)
-		commitRecord->setOpenedValue(calculateZeroShare(commitRecord->getfx_0()));//we also save f(0,0) to avoid calculating it from fx_0 every time
 	}
 	interact();
+	/*
+	 * Commitment IDs as declared by their owners in Step 1. Owner refers to her commitments with these IDs
+	 * in her broadcasts. (Our record might have been created with a different ID, see 'CommitmentTable::addRecord')
+	 */
+	unordered_map<CommitmentId, CommitmentId> declaredIds;
 	{//Step 2 - calculate points on received verifiable shares/polynomials and privately exchange (for all commitments)
 		MessagePtr messages[N];
 		for (ulong i = 0; i < N; ++i) {
@@ -946,29 +2407,32 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 		}
 		for (ulong i = 0; i < N; ++i) {
 			if (channels[i]->hasMsg()) {
-				MessagePtr m = channels[i]->recv();
-				CommitmentId cid = m->getCommitId(); //each message declares a single commitment of a different party
-				if (m->getSender() != pid) { //create commit record for commitments of other parties
-					const bool disallowedID = (cid.compare(0, SHARE_PREFIX.size(), SHARE_PREFIX) == 0);
-					if (disallowedID) {
-						cid = commitments->addRecord(m->getSender());
-					} else {
-						cid = commitments->addRecord(m->getSender(), cid);
+				MessagePtr batch = channels[i]->recv();
+				for (auto const& m : batch->getBatchMessages()) {
+					CommitmentId cid = m->getCommitId(); //each message declares a single commitment of the sender
+					if (batch->getSender() != pid) { //create commit record for commitments of other parties
+						const bool disallowedID = (cid.compare(0, SHARE_PREFIX.size(), SHARE_PREFIX) == 0);
+						if (disallowedID) {
+							cid = commitments->addRecord(batch->getSender());
+						} else {
+							cid = commitments->addRecord(batch->getSender(), cid);
+						}
 					}
-				}
-				commitments->getRecord(cid)->setVerifiableShare(m->getVerifiableShare());
-				calculatePartyShares(m->getVerifiableShare());
-				for (ulong j = 0; j < N; ++j) {//distribute shares for single commit to N messages for N parties
-					fmpz_set(value, shares+j);
+					declaredIds[cid] = m->getCommitId();
+					commitments->getRecord(cid)->setVerifiableShare(m->getVerifiableShare());
+					calculatePartyShares(m->getVerifiableShare());
+					for (ulong j = 0; j < N; ++j) {//distribute shares for single commit to N messages for N parties
+						fmpz_set(value, shares+j);
 #ifdef COMMITMENT_SEND_INVALID_SHARE
-					if (dishonest) {
-						//send defective share to Party 1
-						if (j == 0) {
-							fmpz_add_ui(value, value, 1);// send value+1 instead of value
-						}
-					}//TEST CASE OK (Party 1 disputes all commitments. At Step 4 owners broadcasts disputed values. Broadcast values are accepted. No party gets accused. (Assuming only dishonest behaviour is that described by the test case.))
+						if (dishonest) {
+							//send defective share to Party 1
+							if (j == 0) {
+								fmpz_add_ui(value, value, 1);// send value+1 instead of value
+							}
+						}//TEST CASE OK (Party 1 disputes all commitments. At Step 4 owners broadcasts disputed values. Broadcast values are accepted. No party gets accused. (Assuming only dishonest behaviour is that described by the test case.))
 #endif
-					messages[j]->addVerifier(cid, value);
+						messages[j]->addVerifier(cid, value);
+					}
 				}
 			}
 		}
@@ -1020,6 +2484,7 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 		//First, we update our commitment records with all the broadcast disputes (for all commitments)
 		MessagePtr bm = newMsg();
 		bm->setDebugInfo("Commit step 4");
+		bool anyDisputes = false;
 		for (ulong i = 0; i < N; ++i) {//(we could update records with own disputes in Step 3. Instead we don't ignore the self-message and do it here.)
 			if (broadcast->hasMsg(i+1)) {
 				MessagePtr m = broadcast->recv(i+1);
@@ -1028,26 +2493,44 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 					m->getDisputes(cid, s);
 					for (auto const& disputed : s) {//update commitment records with disputes
 						commitments->getRecord(cid)->addDispute(m->getSender(), disputed);
+						anyDisputes = true;
 					}
 				}
 			}
 		}
-		//Then, for our own commitment, we broadcast all disputed values
-		CommitmentRecord* cr = commitments->getRecord(commitid);
-		auto const& disputes = cr->getDisputes();
-		for (auto const&  d : disputes) {
+		if (optimisticCommitments && !anyDisputes) {
 			/*
-			 * Note: If party m disputes party n, and n disputes m,
-			 * there is no need to evaluate and send both f(m,n) and f(n,m).
-			 * We choose to send both, and later we will expect to receive
-			 * values for both.
+			 * Optimistic fast path : Nobody complained about any of the ongoing commitments, so there is nothing
+			 * to broadcast or accuse in Steps 4-7. (All honest agree on this, since disputes were broadcast.)
+			 * We conclude all commitments right away.
 			 */
-			f.evaluate(value, d.disputer, d.disputed);
-			bm->setCommitId(commitid);
+			concludeCommitments(cids);
+			interact();
+			return commitids;
+		}
+		//Then, for each of our own commitments, we broadcast all disputed values
+		for (ulong j = 0; j < count; ++j) {
+			CommitmentRecord* cr = commitments->getRecord(commitids[j]);
+			auto const& disputes = cr->getDisputes();
+			if (disputes.empty()) {
+				continue;
+			}
+			MessagePtr dm = newMsg();
+			dm->setCommitId(commitids[j]);
+			for (auto const&  d : disputes) {
+				/*
+				 * Note: If party m disputes party n, and n disputes m,
+				 * there is no need to evaluate and send both f(m,n) and f(n,m).
+				 * We choose to send both, and later we will expect to receive
+				 * values for both.
+				 */
+				polys[j]->evaluate(value, d.disputer, d.disputed);
 #ifdef COMMITMENT_DO_NOT_OPEN_DISPUTED
-			if (!dishonest)//TEST CASE OK (If disputed owner refuses to open, her commitment fails and she is marked as corrupt)
+				if (!dishonest)//TEST CASE OK (If disputed owner refuses to open, her commitment fails and she is marked as corrupt)
 #endif
-			bm->addDisputedValue(d.disputer, d.disputed, value);
+				dm->addDisputedValue(d.disputer, d.disputed, value);
+			}
+			bm->addBatchMessage(dm);
 		}
 		broadcast->broadcast(bm);
 	}
@@ -1062,13 +2545,16 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 		for (auto const& cid : cids) {
 			CommitmentRecord* cr = commitments->getRecord(cid);
 			auto const& disputes = cr->getDisputes();
+			MessagePtr m = nullptr;//owner's broadcast for this commitment
+			if (!disputes.empty() && broadcast->hasMsg(cr->getOwner())) {
+				m = broadcast->recv(cr->getOwner())->getBatchMessage(declaredIds[cid]);
+			}
 			if (cr->getOwner() != pid) {
 				for (auto const& d : disputes) {
-					if (!broadcast->hasMsg(cr->getOwner())) {//there was dispute over commitment, but the owner did not open
+					if (m == nullptr) {//there was dispute over commitment, but the owner did not open
 						bm->addAccused(cr->getOwner(), "Did not open (No message)");
 						break;//we don't need to check any more disputes for this cid. we continue with next cid.
 					}
-					MessagePtr m = broadcast->recv(cr->getOwner());
 					bool disputeOpened = m->getDisputedValue(d.disputer, d.disputed, value);//temporarily store in 'value'
 					if (!disputeOpened) {
 						bm->addAccused(cr->getOwner(), "Did not open. "+to_string(d.disputer)+" - "+to_string(d.disputed));
@@ -1088,9 +2574,8 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 #endif
 				}
 			}
-			for (auto const& d : disputes) {//Record broadcast disputed values. They will be used for further consistency checks in in Step 7 (if any broadcasts occur in Step 6)
-				if (broadcast->hasMsg(cr->getOwner())) {
-					MessagePtr m = broadcast->recv(cr->getOwner());
+			if (m != nullptr) {
+				for (auto const& d : disputes) {//Record broadcast disputed values. They will be used for further consistency checks in in Step 7 (if any broadcasts occur in Step 6)
 					if (m->getDisputedValue(d.disputer, d.disputed, value)) {//temporarily store in 'value')
 						cr->setDisputeValue(d.disputer, d.disputed, value);
 					}
@@ -1106,7 +2591,7 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 	}
 	interact();
 	{//Step 6
-		//We update our commitment records with accusations (for all commitments)
+		//We update our commitment records with accusations (for all commitments). An accusation applies to all commitments of the accused.
 		MessagePtr bm = newMsg();
 		bm->setDebugInfo("Commit step 6");
 		for (ulong i = 0; i < N; ++i) {
@@ -1114,24 +2599,33 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 				MessagePtr m = broadcast->recv(i+1);
 				auto const& accusedParties = m->getAccusations();
 				for (auto const& ac : accusedParties) {
-					CommitmentRecord* cr = commitments->getRecordForOngoingCommitment(ac.accused);
-					cr->addAccuser(m->getSender());
+					for (auto const& cr : commitments->getRecordsForOngoingCommitments(ac.accused)) {
+						cr->addAccuser(m->getSender());
+					}
 				}
 			}
 		}
-		//We broadcast the verifiable shares (previously privately sent to parties in Step 1) of every party that accused us. (for our own commitment)
-		CommitmentRecord* cr = commitments->getRecord(commitid);
-		auto const& accusers = cr->getAccusers();
-		for (auto const& k : accusers) {
-			fmpz_mod_poly_t fk_x;
-			fmpz_mod_poly_init(fk_x, FIELD_PRIME);
-			f.evaluate(fk_x, k);
+		//We broadcast the verifiable shares (previously privately sent to parties in Step 1) of every party that accused us. (for our own commitments)
+		fmpz_mod_poly_t fk_x;
+		fmpz_mod_poly_init(fk_x, FIELD_PRIME);
+		for (ulong j = 0; j < count; ++j) {
+			CommitmentRecord* cr = commitments->getRecord(commitids[j]);
+			auto const& accusers = cr->getAccusers();
+			if (accusers.empty()) {
+				continue;
+			}
+			MessagePtr om = newMsg();
+			om->setCommitId(commitids[j]);
+			for (auto const& k : accusers) {
+				polys[j]->evaluate(fk_x, k);
 #ifdef COMMITMENT_ACCUSED_DO_NOT_OPEN_VERIFIABLE_SHARE
-			if(!dishonest)// TEST CASE OK  (Commitment fails and the owner is identified as corrupt)
+				if(!dishonest)// TEST CASE OK  (Commitment fails and the owner is identified as corrupt)
 #endif
-			bm->addOpenedVerifiableShare(k, fk_x);
-			fmpz_mod_poly_clear(fk_x);
+				om->addOpenedVerifiableShare(k, fk_x);
+			}
+			bm->addBatchMessage(om);
 		}
+		fmpz_mod_poly_clear(fk_x);
 		broadcast->broadcast(bm);
 	}
 	interact();
@@ -1143,11 +2637,10 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 		bm->setDebugInfo("Commit step 7");
 		for (ulong i = 0; i < N; ++i) {
 			PartyId k = i+1;
-			if (k != pid) {
-				CommitmentRecord* cr = commitments->getRecordForOngoingCommitment(k);
-				if (cr == nullptr) {
-					throw PceasException("Missing record for ongoing commitment.");
-				}
+			if (k == pid) {
+				continue;
+			}
+			for (auto const& cr : commitments->getRecordsForOngoingCommitments(k)) {
 				if (cr->getAccusers().empty()) {
 					continue; // no accusers, continue with next commitment
 				}
@@ -1155,8 +2648,13 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 					bm->addAccused(k);
 					continue;//already accused. continue with next commitment.
 				}
+				MessagePtr m = broadcast->recv(k)->getBatchMessage(declaredIds[cr->getCommitid()]);
+				if (m == nullptr) {
+					bm->addAccused(k);
+					cr->setInconsistentBroadcast();//missing broadcast, all honest parties will agree
+					continue;//already accused. continue with next commitment.
+				}
 				unordered_set<PartyId> temp;
-				MessagePtr m = broadcast->recv(k);
 				auto const& openedShares = m->getOpenedVerifiableShares();
 				//first we run over the shares to do check for completeness and updating records
 				for (auto const& ovs : openedShares) {
@@ -1206,41 +2704,50 @@ CommitmentId Party::commit(fmpz_t const& val, CommitmentId predeterminedCommitId
 			if (broadcast->hasMsg(i+1)) {
 				MessagePtr m = broadcast->recv(i+1);
 				for (auto const& ac : m->getAccusations()) {
-					CommitmentRecord* cr = commitments->getRecordForOngoingCommitment(ac.accused);
-					cr->addAccuser(m->getSender());
+					for (auto const& cr : commitments->getRecordsForOngoingCommitments(ac.accused)) {
+						cr->addAccuser(m->getSender());
+					}
 				}
 			}
 		}
-		//If commitment did not fail, we update commitment records with shares
-		for (auto const& cid : cids) {//for each ongoing commitment
-			CommitmentRecord* cr = commitments->getRecord(cid);
-			/*
-			 * If owner broadcast inconsistent information OR
-			 * If more than D parties have accused the commitment owner (meaning, at least one honest party accused),
-			 * we know that commitment owner is corrupt and intended commitment has failed. (All honest will agree on these)
-			 *
-			 * If commitment was for an input (corrupt party providing input in input sharing phase), we will assume [[0,o]] as default input.
-			 * If a commitment failed during the execution of mult gate, we again continue with assumption of [[0,o]]. (In the end, corrupt parties will be excluded from recombination)
-			 * In any case, we force owner to a public commitment to 0, and continue.
-			 */
-			if (cr->isInconsistentBroadcast() || cr->getAccuserCount() > D) {
-				cr->setDone(false);
-				addCorrupt(cr->getOwner());
-				publicCommitToZero(cr);//force a commitment to 0
+		concludeCommitments(cids);
+	}
+	interact();
+	return commitids;
+}
+
+/**
+ * Last step of 'commit' (for all commitments). Decides on success of each ongoing commitment,
+ * and if commitment did not fail, updates commitment record with our share.
+ */
+void Party::concludeCommitments(vector<CommitmentId> const& cids) {
+	for (auto const& cid : cids) {//for each ongoing commitment
+		CommitmentRecord* cr = commitments->getRecord(cid);
+		/*
+		 * If owner broadcast inconsistent information OR
+		 * If more than D parties have accused the commitment owner (meaning, at least one honest party accused),
+		 * we know that commitment owner is corrupt and intended commitment has failed. (All honest will agree on these)
+		 *
+		 * If commitment was for an input (corrupt party providing input in input sharing phase), we will assume [[0,o]] as default input.
+		 * If a commitment failed during the execution of mult gate, we again continue with assumption of [[0,o]]. (In the end, corrupt parties will be excluded from recombination)
+		 * In any case, we force owner to a public commitment to 0, and continue.
+		 */
+		if (cr->isInconsistentBroadcast() || cr->getAccuserCount() > D) {
+			cr->setDone(false);
+			addCorrupt(cr->getOwner());
+			publicCommitToZero(cr);//force a commitment to 0
+		} else {
+			cr->setDone(true);
+			//If commitment did not fail, we update commitment records with shares
+			if (cr->isAccuser(pid) && cr->isNewVerifiableShareBroadcast()) {//we accused and had new polynomial broadcast
+				fmpz_mod_poly_set(poly, cr->getBroadcastVerifiableShare());
 			} else {
-				cr->setDone(true);
-				//If commitment did not fail, we update commitment records with shares
-				if (cr->isAccuser(pid) && cr->isNewVerifiableShareBroadcast()) {//we accused and had new polynomial broadcast
-					fmpz_mod_poly_set(poly, cr->getBroadcastVerifiableShare());
-				} else {
-					fmpz_mod_poly_set(poly, cr->getVerifiableShare());
-				}
-				cr->setShare(calculateZeroShare(poly));
+				fmpz_mod_poly_set(poly, cr->getVerifiableShare());
 			}
+			cr->setShare(calculateZeroShare(poly));
 		}
+		cr->releaseOngoingState();//verifiable shares, disputes and accusations are no longer needed
 	}
-	interact();
-	return commitid;
 }
 
 /**
@@ -1274,23 +2781,39 @@ void Party::publicCommitToZero(CommitmentRecord* cr) {
  * but all will take part in 'open's of other parties.
  */
 void Party::open(CommitmentId commitid) {
+	vector<CommitmentId> commitids;
+	if (commitid != NONE) {
+		commitids.push_back(commitid);
+	}
+	open(commitids);
+}
+
+/**
+ * Commitments with IDs 'commitids' are opened, all in the same rounds. Other parties may open
+ * any number of their own commitments at the same time. f(x,0)s and verifiers for all commitments
+ * being opened are broadcast together, so the number of rounds does not depend on the number of opens.
+ * An empty list means we only participate in 'open's of other parties.
+ */
+void Party::open(vector<CommitmentId> const& commitids) {
 	vector<CommitmentId> opens;//holds commit IDs of commitments being opened
 	{//Step 1
 		MessagePtr bm = newMsg();
-		bm->setDebugInfo("Open step 1 : " + commitid);
-		bm->setCommitId(commitid);
-		if (commitid != NONE) {
+		bm->setDebugInfo("Open step 1 : " + to_string(commitids.size()) + " commitment(s)");
+		for (auto const& commitid : commitids) {
 			CommitmentRecord* cr = commitments->getRecord(commitid);
 			if (cr != nullptr && cr->getOwner() == pid) {
+				MessagePtr m = newMsg();
+				m->setCommitId(commitid);
 #ifdef OPEN_WITH_INVALID_FX0
 				if (dishonest) {
 					//A party tries to open its commitment differently.
 					//TEST CASE OK : 'Open' does not succeed ('Open's of other parties succeed). Party is marked as corrupt.
 					fmpz_mod_poly_neg(poly, cr->getfx_0());
-					bm->setVerifiableShare(poly); // open with the negative instead
+					m->setVerifiableShare(poly); // open with the negative instead
 				} else
 #endif
-				bm->setVerifiableShare(cr->getfx_0());
+				m->setVerifiableShare(cr->getfx_0());
+				bm->addBatchMessage(m);
 			}
 		}
 		broadcast->broadcast(bm);
@@ -1298,22 +2821,25 @@ void Party::open(CommitmentId commitid) {
 	interact();
 	{//Step 2
 		MessagePtr bm = newMsg();
-		bm->setDebugInfo("Open step 2 : " + commitid);
+		bm->setDebugInfo("Open step 2");
+		unordered_set<CommitmentId> seen;
 		for (ulong i = 0; i < N; ++i) {
 			if (broadcast->hasMsg(i+1)) {
-				MessagePtr m = broadcast->recv(i+1);
-				CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
-				if (cr != nullptr && cr->getOwner() == m->getSender()) {
-					opens.push_back(m->getCommitId());
-					cr->setfx_0(m->getVerifiableShare());//update commitment records with received information
+				MessagePtr bmi = broadcast->recv(i+1);
+				for (auto const& m : bmi->getBatchMessages()) {
+					CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
+					if (cr != nullptr && cr->getOwner() == bmi->getSender() && seen.insert(m->getCommitId()).second) {
+						opens.push_back(m->getCommitId());
+						cr->setfx_0(m->getVerifiableShare());//update commitment records with received information
 #ifdef OPEN_SEND_INVALID_VERIFIERS
-					if (dishonest) { //A party tries to sabotage 'open's of other parties by sending invalid verifiers
-						//TEST CASE OK  'open's of honest parties succeed
-						fmpz_add_ui(value, cr->getShare(), 1); // send verifier + 1 instead of verifier
-						bm->addVerifier(m->getCommitId(), value);
-					} else
+						if (dishonest) { //A party tries to sabotage 'open's of other parties by sending invalid verifiers
+							//TEST CASE OK  'open's of honest parties succeed
+							fmpz_add_ui(value, cr->getShare(), 1); // send verifier + 1 instead of verifier
+							bm->addVerifier(m->getCommitId(), value);
+						} else
 #endif
-					bm->addVerifier(m->getCommitId(), cr->getShare());
+						bm->addVerifier(m->getCommitId(), cr->getShare());
+					}
 				}
 			}
 		}
@@ -1321,95 +2847,139 @@ void Party::open(CommitmentId commitid) {
 	}
 	interact();
 	{//Step 3
+		vector<CommitmentRecord*> wellFormed;
 		for (CommitmentId cid : opens) {
 			CommitmentRecord* cr = commitments->getRecord(cid);
 			if (MathUtil::degreeCheckLTE(cr->getfx_0(), D)) {//first check the polynomial received in Step 2
-				//then check that we received sufficiently many valid shares
-				ulong counter = 0;//number of valid shares
-				for (ulong i = 0; i < N; ++i) {
-					bool found = broadcast->hasMsg(i+1) && broadcast->recv(i+1)->getVerifier(cid, value);//temporarily store sent value in 'value'
-					if (found) {
-						calculatePartyShare(i, cr->getfx_0());
-						if (fmpz_equal(value, shares+i) != 0) {//EQUAL
-							counter++;
-						}
-					}
-				}
-				if (counter > 2*D) {//as the value of counter is solely determined by information from consenses broadcast, all honest parties will agree on it.
-					cr->setOpened();
-					cr->setOpenedValue(calculateZeroShare(cr->getfx_0()));//f(0,0)
-				} else {
-					addCorrupt(cr->getOwner());
-				}
+				wellFormed.push_back(cr);
+			} else {
+				addCorrupt(cr->getOwner());
+			}
+		}
+		//then check that we received sufficiently many valid shares
+		const vector<ulong> counters = countValidVerifiers(wellFormed, [this](ulong i, CommitmentId const& cid, fmpz_t& val){
+			return broadcast->hasMsg(i+1) && broadcast->recv(i+1)->getVerifier(cid, val);
+		});
+		for (ulong j = 0; j < wellFormed.size(); ++j) {
+			CommitmentRecord* cr = wellFormed[j];
+			if (counters[j] > 2*D) {//as the value of counter is solely determined by information from consenses broadcast, all honest parties will agree on it.
+				cr->setOpened();
+				cr->setOpenedValue(calculateZeroShare(cr->getfx_0()));//f(0,0)
 			} else {
 				addCorrupt(cr->getOwner());
 			}
 		}
 	}
-	interact();
+	interact();
+}
+
+/**
+ * Commitment with ID 'commitid' is opened to party 'k'
+ * Note : Other parties can simultaneously do 'designatedOpen's, to any targets.
+ */
+void Party::designatedOpen(CommitmentId commitid, PartyId k, bool isOutputOpening) {
+	vector<CommitmentId> commitids;
+	if (commitid != NONE) {
+		commitids.push_back(commitid);
+	}
+	designatedOpen(commitids, k, isOutputOpening);
 }
 
 /**
- * Commitment with ID 'commitid' is opened to party 'k'
- * Note : Another party can simultaneously do designatedOpen(commitid', k'),
- * as long as k != k', and k and k' are properly chosen (see getSourceFromTarget).
+ * Commitments with IDs 'commitids' are opened to party 'k', all in the same rounds.
+ * An empty list means we only participate in 'designatedOpen's of other parties.
  */
-void Party::designatedOpen(CommitmentId commitid, PartyId k, bool isOutputOpening) {
-	{//Step 1 - Similar to Step 1 of 'open'. We don't broadcast but send privately to 'k'
-		if (commitid != NONE) {
-			MessagePtr mk = newMsg();
-			mk->setDebugInfo("DesignatedOpen step 1 - Private Msg for : " + commitid);
-			CommitmentRecord* cr = commitments->getRecord(commitid);
+void Party::designatedOpen(vector<CommitmentId> const& commitids, PartyId k, bool isOutputOpening) {
+	vector< pair<CommitmentId, PartyId> > opens;
+	for (auto const& commitid : commitids) {
+		opens.push_back(make_pair(commitid, k));
+	}
+	designatedOpen(opens, isOutputOpening);
+}
+
+/**
+ * Each commitment in 'opens' is opened to the party paired with it, all in the same rounds.
+ * Since secure channels can carry any number of messages per round, targets can be chosen freely,
+ * e.g. a commitment can be opened to every other party at once.
+ */
+void Party::designatedOpen(vector< pair<CommitmentId, PartyId> > const& opens, bool isOutputOpening) {
+	{//Step 1 - Similar to Step 1 of 'open'. We don't broadcast but send privately to the target (a single message for each target)
+		MessagePtr bm = newMsg();
+		bm->setDebugInfo("DesignatedOpen step 1 : " + to_string(opens.size()) + " commitment(s)" + (isOutputOpening ? " (Opening Output)" : ""));
+		unordered_map<PartyId, MessagePtr> privateMsgs;
+		for (auto const& op : opens) {
+			CommitmentRecord* cr = commitments->getRecord(op.first);
 			if (cr != nullptr && cr->getOwner() == pid) {
-				mk->setCommitId(commitid);
+				MessagePtr& mk = privateMsgs[op.second];
+				if (mk == nullptr) {
+					mk = newMsg();
+					mk->setDebugInfo("DesignatedOpen step 1 - Private Msg");
+				}
+				MessagePtr m = newMsg();
+				m->setCommitId(op.first);
 #ifdef DESIGNATEDOPEN_WITH_INVALID_FX0
 				if (dishonest) {
 					//A party tries to open its commitment differently.
 					//TEST CASE OK : 'designatedOpen' of dishonest party is rejected. dishonest is forced to do an 'open'.
 					fmpz_mod_poly_neg(poly, cr->getfx_0());
-					mk->setVerifiableShare(poly); // open with the negative instead
+					m->setVerifiableShare(poly); // open with the negative instead
 				} else
 #endif
-				mk->setVerifiableShare(cr->getfx_0());
+				m->setVerifiableShare(cr->getfx_0());
+				mk->addBatchMessage(m);
 			}
-			channels[k-1]->send(mk);
+			//Let others know about the opens (and their targets), so they can participate
+			MessagePtr om = newMsg();
+			om->setCommitId(op.first);
+			om->setTarget(op.second);
+			bm->addBatchMessage(om);
+		}
+		for (auto const& pa : privateMsgs) {
+			channels[pa.first-1]->send(pa.second);
 		}
-		//Let others know about the opens, so they can participate
-		MessagePtr bm = newMsg();
-		bm->setCommitId(commitid);
-		bm->setTarget(k);
-		bm->setDebugInfo("DesignatedOpen step 1 : " + commitid + (isOutputOpening ? " (Opening Output)" : (" Opening to Party " + to_string(k))));
 		broadcast->broadcast(bm);
 	}
 	interact();
 	vector< pair<CommitmentId, PartyId> > designatedOpens;
-	const PartyId expectedOpenerToUs = getSourceFromTarget(pid, pid, k);
+	unordered_map<CommitmentId, PartyId> designatedTargets;
 	{//Step 2 - Similar to Step 2 of 'open'. Verifiers are not broadcast, but sent privately to a single party (for each open)
 		// Learn about ongoing opens
 		for (ulong i = 0; i < N; ++i) {
 			if (broadcast->hasMsg(i+1)) {
 				MessagePtr m = broadcast->recv(i+1);
-				CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
-				if (cr != nullptr && cr->getOwner() == m->getSender()) {
-					designatedOpens.push_back(make_pair(m->getCommitId(), m->getTarget()));
-					if (isOutputOpening) {//All paralel 'designatedOpen's are output openinig, or none
-						cr->markAsOutput();
+				for (auto const& om : m->getBatchMessages()) {
+					CommitmentRecord* cr = commitments->getRecord(om->getCommitId());
+					const PartyId target = om->getTarget();
+					if (cr != nullptr && cr->getOwner() == m->getSender() && target >= 1 && target <= N
+							&& designatedTargets.insert(make_pair(om->getCommitId(), target)).second) {
+						designatedOpens.push_back(make_pair(om->getCommitId(), target));
+						if (isOutputOpening) {//All paralel 'designatedOpen's are output openinig, or none
+							cr->markAsOutput();
+						}
 					}
 				}
 			}
 		}
-		// Process incoming private message (for the commitment being designatedOpened to us)
-		if (channels[expectedOpenerToUs-1]->hasMsg()) {
-			MessagePtr m = channels[expectedOpenerToUs-1]->recv();
-			CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
-			if (cr != nullptr && cr->getOwner() == m->getSender()) {
-				cr->setfx_0(m->getVerifiableShare());//update commitment records with received information
+		// Process incoming private messages (for the commitments being designatedOpened to us, by their owners)
+		for (ulong i = 0; i < N; ++i) {
+			for (auto const& mk : channels[i]->recvAll()) {
+				for (auto const& m : mk->getBatchMessages()) {
+					CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
+					auto it = designatedTargets.find(m->getCommitId());
+					if (cr != nullptr && cr->getOwner() == mk->getSender() && it != designatedTargets.end() && it->second == pid) {
+						cr->setfx_0(m->getVerifiableShare());//update commitment records with received information
+					}
+				}
 			}
 		} // (if no message was sent, fx remains as zero polynomial, which is OK.)
-		// Privately send verifiers for each open
+		// Privately send verifiers for each open (a single message for each target)
+		unordered_map<PartyId, MessagePtr> verifiers;
 		for (auto const& pa : designatedOpens) {
-			MessagePtr mk = newMsg();
-			mk->setDebugInfo("designatedOpen step 2");
+			MessagePtr& mk = verifiers[pa.second];
+			if (mk == nullptr) {
+				mk = newMsg();
+				mk->setDebugInfo("designatedOpen step 2");
+			}
 			CommitmentRecord* cr = commitments->getRecord(pa.first);
 #ifdef DESIGNATEDOPEN_SEND_INVALID_VERIFIERS
 			if (dishonest) { //corrupt party tries to sabotage 'designatedOpen's of other parties by sending invalid verifiers
@@ -1419,77 +2989,90 @@ void Party::designatedOpen(CommitmentId commitid, PartyId k, bool isOutputOpenin
 			} else
 #endif
 			mk->addVerifier(pa.first, cr->getShare());
-			channels[pa.second-1]->send(mk);
+		}
+		for (auto const& pa : verifiers) {
+			channels[pa.first-1]->send(pa.second);
 		}
 	}
 	interact();
-	{//Step 3 - For the commitment being opened to us, we validate received fx_0 with verifiers. If invalid we broadcast reject to force a normal open.
-		//Find the commitment being opened to us
+	{//Step 3 - For the commitments being opened to us, we validate received fx_0 with verifiers. If invalid we broadcast reject to force a normal open.
+		MessagePtr bm = newMsg();
+		bm->setDebugInfo("designatedOpen step 3");
+		bm->setTarget(pid);
+		vector<MessagePtr> received(N);
+		for (ulong i = 0; i < N; ++i) {
+			received[i] = channels[i]->hasMsg() ? channels[i]->recv() : nullptr;
+		}
+		//Find the commitments being opened to us
+		vector<CommitmentRecord*> wellFormed;
 		for (auto const& pa : designatedOpens) {
 			if (pa.second == pid) {
 				CommitmentRecord* cr = commitments->getRecord(pa.first);
-				MessagePtr bm = newMsg();
-				bm->setDebugInfo("designatedOpen step 3");
-				bm->setCommitId(cr->getCommitid());
-				bm->setTarget(pid);
 				if (MathUtil::degreeCheckLTE(cr->getfx_0(), D)) {//first check the polynomial received in Step 2
-					//then check that we received sufficiently many shares
-					ulong counter = 0;//number of valid shares
-					for (ulong i = 0; i < N; ++i) {
-						bool found = channels[i]->hasMsg() && channels[i]->recv()->getVerifier(cr->getCommitid(), value);//temporarily store sent value in 'value'
-						if (found) {
-							calculatePartyShare(i, cr->getfx_0());
-							if (fmpz_equal(value, shares+i) != 0) {//EQUAL
-								counter++;
-							}
-						}
-					}
-					if (counter > 2*D) {
-						cr->addDesignatedOpen(pid);
-						cr->setOpenedValue(calculateZeroShare(cr->getfx_0()));//f(0,0)
-					} else {
-						bm->setDesignatedOpenRejected();
-					}
+					wellFormed.push_back(cr);
 				} else {
-					bm->setDesignatedOpenRejected();
+					MessagePtr m = newMsg();
+					m->setCommitId(cr->getCommitid());
+					m->setDesignatedOpenRejected();
+					bm->addBatchMessage(m);
 				}
-				broadcast->broadcast(bm);
 			}
 		}
+		//then check that we received sufficiently many shares
+		const vector<ulong> counters = countValidVerifiers(wellFormed, [&received](ulong i, CommitmentId const& cid, fmpz_t& val){
+			return received[i] != nullptr && received[i]->getVerifier(cid, val);
+		});
+		for (ulong j = 0; j < wellFormed.size(); ++j) {
+			CommitmentRecord* cr = wellFormed[j];
+			MessagePtr m = newMsg();
+			m->setCommitId(cr->getCommitid());
+			if (counters[j] > 2*D) {
+				cr->addDesignatedOpen(pid);
+				cr->setOpenedValue(calculateZeroShare(cr->getfx_0()));//f(0,0)
+			} else {
+				m->setDesignatedOpenRejected();
+			}
+			bm->addBatchMessage(m);
+		}
+		if (!bm->getBatchMessages().empty()) {
+			broadcast->broadcast(bm);
+		}
 	}
 	interact();
-	{//STEP 4 - Open our commitment if designated open was rejected, or participate in other opens
-		bool oursRejected = false;
+	{//STEP 4 - Open our commitments if designated opens were rejected, or participate in other opens
+		vector<CommitmentId> oursRejected;
 		unordered_set<CommitmentId> rejected;
 		for (ulong i = 0; i < N; ++i) {
 			if (broadcast->hasMsg(i+1)) {
-				MessagePtr m = broadcast->recv(i+1);
-				CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
-				if (cr != nullptr && cr->getOwner() == getSourceFromTarget(m->getSender(), pid, k)) {//only the target can reject
-					if (m->isDesignatedOpenRejected()) {
-						if (cr->getOwner() == pid) {// if our designated open got rejected, we should 'open'
-							oursRejected = true;
+				MessagePtr bm = broadcast->recv(i+1);
+				for (auto const& m : bm->getBatchMessages()) {
+					CommitmentRecord* cr = commitments->getRecord(m->getCommitId());
+					auto it = designatedTargets.find(m->getCommitId());
+					if (cr != nullptr && it != designatedTargets.end() && it->second == bm->getSender()) {//only the target can reject
+						if (m->isDesignatedOpenRejected()) {
+							if (rejected.insert(cr->getCommitid()).second) {
+								if (cr->getOwner() == pid) {// if our designated open got rejected, we should 'open'
+									oursRejected.push_back(cr->getCommitid());
+								}
+							}
+						} else {
+							cr->addDesignatedOpen(bm->getSender());
 						}
-						rejected.insert(cr->getCommitid());
 					} else {
-						cr->addDesignatedOpen(m->getSender());
+						addCorrupt(bm->getSender());//all honest will agree
+						break;//continue with next sender's message
 					}
-				} else {
-					addCorrupt(m->getSender());//all honest will agree
 				}
 			}
 		}
+		//all rejected commitments are opened in a single batched 'open' (all honest agree on whether there is any)
 		if (!rejected.empty()) {
-			if (oursRejected) {
 #ifdef DESIGNATEDOPEN_DO_NOT_OPEN_REJECTED
-				if (dishonest) { //A party whose 'designatedOpen' got rejected, refuses to do an 'open'
-					open();//TEST CASE OK : Commitment remains unopened. As a result, party is marked as corrupt.
-				} else
-#endif
-				open(commitid);
-			} else {
-				open();//we won't open anything, but participate in 'open's of other partie(s)
+			if (dishonest) { //A party whose 'designatedOpen' got rejected, refuses to do an 'open'
+				oursRejected.clear();//TEST CASE OK : Commitment remains unopened. As a result, party is marked as corrupt.
 			}
+#endif
+			open(oursRejected);//INTERACTIVE (if 'oursRejected' is empty, we won't open anything, but participate in 'open's of other partie(s))
 		}
 		for (auto const& cid : rejected) {
 			CommitmentRecord* cr = commitments->getRecord(cid);
@@ -1508,10 +3091,38 @@ void Party::designatedOpen(CommitmentId commitid, PartyId k, bool isOutputOpenin
  * Note : Another party may be simultaneously trying transferCommit(commitid', k')
  */
 void Party::transferCommitment(CommitmentId commitid, PartyId k) {
+	transferCommitment(vector<CommitmentId>(1, commitid), k);
+}
+
+/**
+ * Batched 'Perfect Transfer'
+ *
+ * Commitments with IDs 'commitids' are all transfered to party 'k', in the same rounds.
+ * Note : Other parties may be simultaneously transfering their own lists of commitments (possibly of different sizes)
+ * to their own targets. An empty list means we only participate.
+ */
+void Party::transferCommitment(vector<CommitmentId> const& commitids, PartyId k) {
+	vector< pair<CommitmentId, PartyId> > transfers;
+	for (auto const& commitid : commitids) {
+		transfers.push_back(make_pair(commitid, k));
+	}
+	transferCommitment(transfers);
+}
+
+/**
+ * Batched 'Perfect Transfer' to many targets
+ *
+ * Each commitment in 'transfers' is transfered to the party paired with it. All transfers (to all targets)
+ * run in the same rounds, and disputes about any of them are resolved together. Hence the number of rounds
+ * does not depend on the number of targets.
+ */
+void Party::transferCommitment(vector< pair<CommitmentId, PartyId> > const& transfers) {
 	{//Step 0 Let every party know which commitments are being transfered
 		MessagePtr bm = newMsg();
-		bm->setDebugInfo("transfer commitment step 0 : " + commitid + " to Party " + to_string(k));
-		bm->addTransfer(commitid, pid, k);
+		bm->setDebugInfo("transfer commitment step 0 : " + to_string(transfers.size()) + " commitment(s)");
+		for (auto const& tr : transfers) {
+			bm->addTransfer(tr.first, pid, tr.second);
+		}
 		broadcast->broadcast(bm);
 	}
 	interact();
@@ -1522,54 +3133,59 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 			PartyId sender = i + 1;
 			if (broadcast->hasMsg(sender)) {
 				auto const& receivedTransfers = broadcast->recv(sender)->getTransfers();
-				if (receivedTransfers.size() == 1) {//we expect exactly 1 transfer per party
-					CommitmentTransfer ct = receivedTransfers.back();
-					const bool sourceTargetMatch = (ct.transferSource == getSourceFromTarget(ct.transferTarget, pid, k));
+				vector<CommitmentTransfer> accepted;
+				unordered_set<CommitmentId> cids;
+				for (auto const& ct : receivedTransfers) {
+					const bool targetOk = (ct.transferTarget >= 1 && ct.transferTarget <= N && ct.transferTarget != ct.transferSource);
 					CommitmentRecord* cr = commitments->getRecord(ct.commitId);
 					const bool recordOk = ((cr != nullptr) && (cr->isSuccess()) && (cr->getOwner() == ct.transferSource) && (cr->getOwner() == sender));
-					if (sourceTargetMatch && recordOk) {//all honest will agree
-						CommitmentTransfer newCt(ct.commitId, ct.transferSource, ct.transferTarget);//ignore anything else the sent message contains
-						vecTrans.push_back(newCt);
-					} else{
-						addCorrupt(sender);
+					if (!targetOk || !recordOk || !cids.insert(ct.commitId).second) {//all honest will agree
+						break;
 					}
+					CommitmentTransfer newCt(ct.commitId, ct.transferSource, ct.transferTarget);//ignore anything else the sent message contains
+					accepted.push_back(newCt);
+				}
+				if (accepted.size() == receivedTransfers.size()) {
+					vecTrans.insert(vecTrans.end(), accepted.begin(), accepted.end());
 				} else {
 					addCorrupt(sender);
 				}
 			}
 		}
-		//designatedOpen to transfer target
-		designatedOpen(commitid, k);//INTERACTIVE
+		//designatedOpen to transfer targets
+		designatedOpen(transfers);//INTERACTIVE
 	}
-	{//Step 2 - Mark transfers with failed opens to be handled in Step 5. Commit to value opened to us.
-		CommitmentTransfer transToUs;
+	{//Step 2 - Mark transfers with failed opens to be handled in Step 5. Commit to values opened to us.
+		vector<CommitmentTransfer> transToUs;
 		for (auto& t : vecTrans) {
 			if (!t.error) {
 				CommitmentRecord* cr = commitments->getRecord(t.commitId);
 				t.error = !cr->isValueOpenTo(t.transferTarget);
 				if (!t.error && (pid == t.transferTarget)) {
-					transToUs = t;
-					fmpz_set(value, cr->getOpenedValue());//store until commit
+					transToUs.push_back(t);
 				}
 			}
 		}
-		if (!transToUs.error) {
+		fmpz* vals = _fmpz_vec_init(transToUs.size());
+		vector<CommitmentId> ids;
+		for (auto const& t : transToUs) {
+			fmpz* val = vals + ids.size();
+			fmpz_set(val, commitments->getRecord(t.commitId)->getOpenedValue());
 #ifdef TRANSFER_TARGET_COMMITS_TO_DIFFERENT_VALUE
-			if (dishonest && transToUs.transferSource == 3) { //dishonest transfer target will commit to a value different than what was transfered to her (by Party 3)
+			if (dishonest && t.transferSource == 3) { //dishonest transfer target will commit to a value different than what was transfered to her (by Party 3)
 				//TEST CASE OK : Transfer to dishonest party is rejected. Transfered share is set with a public commitment
 				//to value opened by honest transfer source (hence consistency of shares is guaranteed for the ongoing VSS).
-				fmpz_add_ui(value, value, 1); // commit to value + 1 instead of value
+				fmpz_add_ui(val, val, 1); // commit to value + 1 instead of value
 			}
 #endif
-			commit(value, getTransferedCommitId(transToUs));//INTERACTIVE
-		} else {//Participate in other's commitments (We make a dummy commitment to 0)
-			fmpz_zero(value);
-			commit(value);//INTERACTIVE
+			ids.push_back(getTransferedCommitId(t));
 		}
+		commit(vals, ids.size(), ids);//INTERACTIVE (If nothing is transfered to us, we only participate in other's commitments)
+		_fmpz_vec_clear(vals, transToUs.size());
 	}
-	{//Step 3 - We will enable other parties to check that the value we committed to is the same value original owner had committed to. Other 'transferTarget's will do the same.
+	{//Step 3 - We will enable other parties to check that the values we committed to are the same values original owner had committed to. Other 'transferTarget's will do the same.
 		//Mark transfers with failed commitments to be handled in Step 5.
-		CommitmentTransfer transFromUs;
+		vector<CommitmentTransfer> transFromUs;
 		for (auto& t : vecTrans) {
 			if (!t.error) {
 				CommitmentRecord* cr = commitments->getRecord(getTransferedCommitId(t));
@@ -1579,31 +3195,27 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 					t.error = true;
 				}
 			}
-			if (pid == t.transferSource) {
-				transFromUs = t;
+			if (pid == t.transferSource && !t.error) {
+				transFromUs.push_back(t);
 			}
 		}
 		fmpz_mod_poly_t f;
 		fmpz_mod_poly_init(f, FIELD_PRIME);
-		if (!transFromUs.error) {
+		fmpz* coeffs = _fmpz_vec_init(D*transFromUs.size());
+		vector<CommitmentId> coeffIds;
+		unordered_map<PartyId, MessagePtr> coeffMsgs;//a single message for each target
+		for (auto const& t : transFromUs) {
 			//sample a polynomial with x^0 coefficient set to value (of the commitment which we transfer to Party k)
-			mu->sampleUnivariate(f, commitments->getRecord(commitid)->getOpenedValue(), D);
+			mu->sampleUnivariate(f, commitments->getRecord(t.commitId)->getOpenedValue(), D);
 			for (ulong i = 1; i <= D; ++i) {//commit to each coefficient
-				fmpz_mod_poly_get_coeff_fmpz(value, f, i);
-				commit(value, getCoeffCommitIdForTransfer(commitid, pid, k, i));//INTERACTIVE
+				fmpz_mod_poly_get_coeff_fmpz(coeffs+coeffIds.size(), f, i);
+				coeffIds.push_back(getCoeffCommitIdForTransfer(t.commitId, pid, t.transferTarget, i));
 			}
-		} else {
-			for (ulong i = 1; i <= D; ++i) {//Participate in other's commitments (We make dummy commitments to 0)
-				fmpz_zero(value);
-				commit(value);//INTERACTIVE
-			}
-		}
-		if (!transFromUs.error) {
-			//we privately send the coefficients of the sampled polynomial to target of transfer
+			//we will privately send the coefficients of the sampled polynomial to target of transfer
 			fmpz_zero(value);
 			fmpz_mod_poly_set_coeff_fmpz(f, 0, value);//overwrite the zero coefficient with 0
 #ifdef TRANSFER_SOURCE_SENDS_BAD_COEFFICIENT
-			if (dishonest && transFromUs.transferTarget == 3) { //dishonest 'transfer source' will privately send a wrong value for the 1st coefficient (to Party 3)
+			if (dishonest && t.transferTarget == 3) { //dishonest 'transfer source' will privately send a wrong value for the 1st coefficient (to Party 3)
 				//TEST CASE OK : Transfer from dishonest party is rejected. Dishonest transfer source opens her commitment,
 				//and a public commitment is made to that value (hence consistency of shares is guaranteed for the ongoing VSS)
 				fmpz_mod_poly_get_coeff_fmpz(value, f, 1);
@@ -1611,46 +3223,51 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 				fmpz_mod_poly_set_coeff_fmpz(f, 1, value);// 1st coefficient set to original value + 1
 			}
 #endif
-			MessagePtr m = newMsg();
-			m->setDebugInfo("transfer commitment step 3 : " + commitid);
-			m->setVerifiableShare(f);
-			channels[k-1]->send(m);
+			MessagePtr& m = coeffMsgs[t.transferTarget];
+			if (m == nullptr) {
+				m = newMsg();
+				m->setDebugInfo("transfer commitment step 3");
+			}
+			MessagePtr mt = newMsg();
+			mt->setCommitId(t.commitId);
+			mt->setVerifiableShare(f);
+			m->addBatchMessage(mt);
+		}
+		commit(coeffs, coeffIds.size(), coeffIds);//INTERACTIVE (If we transfer nothing, we only participate in other's commitments)
+		_fmpz_vec_clear(coeffs, D*transFromUs.size());
+		for (auto const& pa : coeffMsgs) {
+			channels[pa.first-1]->send(pa.second);
 		}
 		fmpz_mod_poly_clear(f);
 	}
 	interact();
 	{
-		fmpz_mod_poly_t g;//holds the polynomial sampled by the transfer source (except 0 coefficient) for the transfer in which we are transfer target.
+		fmpz_mod_poly_t g;//holds the polynomial sampled by the transfer source (except 0 coefficient) for a transfer in which we are transfer target.
 		fmpz_mod_poly_init(g, FIELD_PRIME);
-		CommitmentTransfer transToUs;
+		fmpz* coeffs = _fmpz_vec_init(D*vecTrans.size());
+		vector<CommitmentId> coeffIds;
 		for (auto& t : vecTrans) {
-			if (t.transferTarget == pid) {//we receive the coefficients for the transfer in which we are the target
-				if (!t.error) {
-					if (channels[t.transferSource-1]->hasMsg()) {
-						MessagePtr mCoeff = channels[t.transferSource-1]->recv();
-						if (MathUtil::degreeCheckEQ(mCoeff->getVerifiableShare(), D)) {
-							fmpz_mod_poly_set(g, mCoeff->getVerifiableShare());
-						} else {//we know at this point that transfer source is corrupt, but we don't mark it yet because other honest do not know.
-							fmpz_mod_poly_zero(g);//we will assume dishonest sent zeroes. Source will have to open later.
-						}
-					} else {//we know at this point that transfer source is corrupt, but we don't mark it yet because other honest do not know.
-						fmpz_mod_poly_zero(g);//we will assume dishonest sent zeroes. Source will have to open later.
+			if (t.transferTarget == pid && !t.error) {//we receive the coefficients for the transfers in which we are the target (from the transfer source)
+				MessagePtr mCoeff = nullptr;
+				for (auto const& mCoeffs : channels[t.transferSource-1]->recvAll()) {
+					mCoeff = mCoeffs->getBatchMessage(t.commitId);
+					if (mCoeff != nullptr) {
+						break;
 					}
 				}
-				transToUs = t;
-			}
-		}
-		if (!transToUs.error) {
-			for (ulong i = 1; i <= D; ++i) {//commit to each coefficient received
-				fmpz_mod_poly_get_coeff_fmpz(value, g, i);
-				commit(value, getCoeffCommitIdForTransfer(transToUs.transferedCommitId, transToUs.transferSource, transToUs.transferTarget, i));//INTERACTIVE
-			}
-		} else {
-			for (ulong i = 1; i <= D; ++i) {//Participate in other's commitments (We make dummy commitments to 0)
-				fmpz_zero(value);
-				commit(value);//INTERACTIVE
+				if (mCoeff != nullptr && MathUtil::degreeCheckEQ(mCoeff->getVerifiableShare(), D)) {
+					fmpz_mod_poly_set(g, mCoeff->getVerifiableShare());
+				} else {//we know at this point that transfer source is corrupt, but we don't mark it yet because other honest do not know.
+					fmpz_mod_poly_zero(g);//we will assume dishonest sent zeroes. Source will have to open later.
+				}
+				for (ulong i = 1; i <= D; ++i) {//commit to each coefficient received
+					fmpz_mod_poly_get_coeff_fmpz(coeffs+coeffIds.size(), g, i);
+					coeffIds.push_back(getCoeffCommitIdForTransfer(t.transferedCommitId, t.transferSource, t.transferTarget, i));
+				}
 			}
 		}
+		commit(coeffs, coeffIds.size(), coeffIds);//INTERACTIVE (If nothing is transfered to us, we only participate in other's commitments)
+		_fmpz_vec_clear(coeffs, D*vecTrans.size());
 		/*
 		 * No more commitments will happen during transfers. Mark all transfers with failed commits if
 		 * source or target is corrupt. (Failed 'commit's mark parties as corrupt. Equivalently, we could
@@ -1667,7 +3284,6 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 		 * (We are going to do 'designatedOpen's next, and before we can do that every party
 		 * must form these commitment records, at least for the shares they will receive.)
 		 */
-		CommitmentTransfer transFromUs;
 		for (auto& t : vecTrans) {
 			if (!t.error) {
 				for (PartyId k = 1; k <= N; ++k) {
@@ -1675,31 +3291,26 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 					t.addGkx(k, combineCoeffCommitsForTransfer(t.transferedCommitId, k, t.transferSource, t.transferTarget));
 				}
 			}
-			if (t.transferSource == pid) {
-				transFromUs = t;
-			}
-			if (t.transferTarget == pid) {
-				transToUs = t;
-			}
-		}
-		//for the commitment we are trying to transfer, open the commitments to corresponding parties
-		for (ulong i = 1; i < N; ++i) {//we start from i = 1, so that we don't open to self
-			PartyId k = getTargetForIteration(i);
-			if (!transFromUs.error) {
-				designatedOpen(transFromUs.getFkx(k), k);//INTERACTIVE
-			} else {//We are not the source for any transfer. We will not 'designatedOpen' anything, but will participate in other's 'designatedOpen's.
-				designatedOpen(NONE, k);//INTERACTIVE
-			}
 		}
-		//for the commitment being transfered to us, open the commitments to corresponding parties
-		for (ulong i = 1; i < N; ++i) {//we start from i = 1, so that we don't open to self
-			PartyId k = getTargetForIteration(i);
-			if (!transToUs.error) {
-				designatedOpen(transToUs.getGkx(k), k);//INTERACTIVE
-			} else {//We are not the target for any transfer. We will not 'designatedOpen' anything, but will participate in other's 'designatedOpen's.
-				designatedOpen(NONE, k);//INTERACTIVE
+		//for the commitments we are trying to transfer, and for the commitments being transfered to us,
+		//open the commitments to corresponding parties (both in the same 'designatedOpen's)
+		//(all targets at once, we don't open to self)
+		vector< pair<CommitmentId, PartyId> > toOpen;
+		for (PartyId k = 1; k <= N; ++k) {
+			if (k != pid) {
+				for (auto const& t : vecTrans) {
+					if (!t.error) {
+						if (t.transferSource == pid) {
+							toOpen.push_back(make_pair(t.getFkx(k), k));
+						}
+						if (t.transferTarget == pid) {
+							toOpen.push_back(make_pair(t.getGkx(k), k));
+						}
+					}
+				}
 			}
 		}
+		designatedOpen(toOpen);//INTERACTIVE (If we are neither source nor target of any transfer, we only participate in other's 'designatedOpen's)
 		fmpz_mod_poly_clear(g);
 	}
 	{//Step 4 - For each ongoing transfer of commitment, check consistency of commitments opened to us.
@@ -1750,41 +3361,23 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 		}
 		//Next, we open the commitments for the rejected transfers for which we are either the source or the target,
 		//and we also participate in the open's of other parties
-		unordered_map<PartyId, ulong> numberOfOpensPerParty;// 'open's are done in parallel to reduce number of rounds
-		CommitmentTransfer transFromUs, transToUs;
+		bool anyOpens = false;// all 'open's are done in a single batched 'open' to reduce number of rounds
+		vector<CommitmentId> myOpens;
 		for (auto& t : vecTrans) {
-			if (t.transferSource == pid) {
-				transFromUs = t;
-			}
-			if (t.transferTarget == pid) {
-				transToUs = t;
-			}
 			if (!t.error) {
-				auto const& is = numberOfOpensPerParty.insert(make_pair(t.transferSource, 0));
-				auto const& it = numberOfOpensPerParty.insert(make_pair(t.transferTarget, 0));
-				is.first->second += t.rejecters.size();
-				it.first->second += t.rejecters.size();
-			}
-		}
-		ulong maxNumberOfOpensPerParty = 0;
-		for (auto const& p : numberOfOpensPerParty) {
-			if (p.second > maxNumberOfOpensPerParty) {
-				maxNumberOfOpensPerParty = p.second;
-			}
-		}
-		if (!transFromUs.error) {
-			for (auto const& k : transFromUs.rejecters) {
-				open(transFromUs.getFkx(k));//INTERACTIVE
-			}
-		}
-		if (!transToUs.error) {
-			for (auto const& k : transToUs.rejecters) {
-				open(transToUs.getGkx(k));//INTERACTIVE
+				anyOpens = anyOpens || t.isRejected();
+				for (auto const& k : t.rejecters) {
+					if (t.transferSource == pid) {
+						myOpens.push_back(t.getFkx(k));
+					}
+					if (t.transferTarget == pid) {
+						myOpens.push_back(t.getGkx(k));
+					}
+				}
 			}
 		}
-		ulong participations = (maxNumberOfOpensPerParty - ((transFromUs.error ? 0 : transFromUs.rejecters.size()) + (transToUs.error ? 0 : transToUs.rejecters.size())));
-		for (ulong i = 0; i < participations; ++i) {
-			open();//INTERACTIVE
+		if (anyOpens) {
+			open(myOpens);//INTERACTIVE
 		}
 		/*
 		 * Now that all rejected have been opened, every party can compare the opened values
@@ -1820,26 +3413,25 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
 		}
 	}
 	{//Step 5 - At this point, 'error' flag is set to true for all transfers in which one or both of (source, target) is corrupt. All honest will agree on the flag values.
-		CommitmentTransfer transFromUs, transToUs;
-		for (auto& t : vecTrans) {
-			if (t.transferSource == pid) {
-				transFromUs = t;
-			}
-			if (t.transferTarget == pid) {
-				transToUs = t;
+		//if a transfer from us is marked as erronous, we open our commitment (note : this will not prove that we were honest before. but it will enable a public commitment by honest parties)
+		bool anyOpens = false;//(all honest agree on the error flags, hence on whether there is any 'open')
+		vector<CommitmentId> myOpens;
+		for (auto const& t : vecTrans) {
+			if (t.error) {
+				anyOpens = true;
+				if (t.transferSource == pid) {
+					myOpens.push_back(t.commitId);
+				}
 			}
 		}
-		//if transfer from us is marked as erronous, we open our commitment (note : this will not prove that we were honest before. but it will enable a public commitment by honest parties)
-		if (transFromUs.error) {
+		if (anyOpens) {
 #ifdef TRANSFER_SOURCE_DO_NOT_OPEN_ERRONEOUS
-				if(dishonest) {//dishonest transfer source refuses to open commitment
-					//TEST CASE OK : Transfer source is marked as corrupt. Consequently, 0 is used instead of shares distributed by her for the ongoing VSS.
-					open();//INTERACTIVE
-				} else
+			if(dishonest) {//dishonest transfer source refuses to open commitment
+				//TEST CASE OK : Transfer source is marked as corrupt. Consequently, 0 is used instead of shares distributed by her for the ongoing VSS.
+				myOpens.clear();
+			}
 #endif
-			open(transFromUs.commitId);//INTERACTIVE
-		} else {//participate in 'open's of others
-			open();//INTERACTIVE
+			open(myOpens);//INTERACTIVE (if 'myOpens' is empty, we participate in 'open's of others)
 		}
 		for (auto& t : vecTrans) {
 			if (t.error) {
@@ -1868,34 +3460,56 @@ void Party::transferCommitment(CommitmentId commitid, PartyId k) {
  * Note : Other parties will simultaneously run multiplyCommit(CommitmentId cid1', CommitmentId cid2')
  */
 CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
-	CommitmentRecord* cr1 = nullptr;
-	CommitmentRecord* cr2 = nullptr;
-	CommitmentId cid3 = NONE;
+	return multiplyCommitments(vector< pair<CommitmentId, CommitmentId> >(1, make_pair(cid1, cid2))).front();
+}
+
+/**
+ * Batched 'Perfect Commitment Multiplication'
+ *
+ * For each pair (cid1, cid2), a new commitment is made to the product of their values.
+ * Commitments to all products and to the coefficients of all f, g, h polynomials are done together,
+ * and the checks for all multiplications are run in the same rounds.
+ * Note : Other parties will simultaneously run multiplyCommitments with their own lists of pairs (possibly of different sizes).
+ */
+vector<CommitmentId> Party::multiplyCommitments(vector< pair<CommitmentId, CommitmentId> > const& pairs) {
+	const ulong count = pairs.size();
+	vector<CommitmentId> products;
 	{//Step1
 		//Check preconditions
-		cr1 = commitments->getRecord(cid1);
-		if (cr1 == nullptr || cr1->getOwner() != pid) {
-			throw PceasException("Bad commitid in multiplyCommit :"+cid1);
-		}
-		cr2 = commitments->getRecord(cid2);
-		if (cr2 == nullptr || cr2->getOwner() != pid) {
-			throw PceasException("Bad commitid in multiplyCommit :"+cid2);
-		}
-		//commit to the product
-		fmpz_mul(value, cr1->getOpenedValue(), cr2->getOpenedValue());
-		cid3 = getMultipliedCommitId(cid1, cid2);
+		fmpz* vals = _fmpz_vec_init(count);
+		vector<CommitmentId> cid3s;
+		for (ulong j = 0; j < count; ++j) {
+			CommitmentRecord* cr1 = commitments->getRecord(pairs[j].first);
+			if (cr1 == nullptr || cr1->getOwner() != pid) {
+				throw PceasException("Bad commitid in multiplyCommit :"+pairs[j].first);
+			}
+			CommitmentRecord* cr2 = commitments->getRecord(pairs[j].second);
+			if (cr2 == nullptr || cr2->getOwner() != pid) {
+				throw PceasException("Bad commitid in multiplyCommit :"+pairs[j].second);
+			}
+			CommitmentId cid3 = getMultipliedCommitId(pairs[j].first, pairs[j].second);
+			if (find(cid3s.begin(), cid3s.end(), cid3) != cid3s.end()) {
+				throw PceasException("Duplicate multiplication :"+cid3);
+			}
+			cid3s.push_back(cid3);
+			//commit to the product
+			fmpz_mul(vals+j, cr1->getOpenedValue(), cr2->getOpenedValue());
 #ifdef MULTIPLICATION_COMMIT_TO_DIFFERENT_VALUE
 			if (dishonest) { //dishonest will commit to a value different than the product of values for cid1 and cid2.
 				//TEST CASE OK : Multiplication is rejected, and this party is identified as corrupt. Other multiplications are not affected.
-				fmpz_add_ui(value, value, 1); // commit to value + 1 instead of value
+				fmpz_add_ui(vals+j, vals+j, 1); // commit to value + 1 instead of value
 			}
 #endif
-		commit(value, cid3);//INTERACTIVE
+		}
+		products = commit(vals, count, cid3s);//INTERACTIVE
+		_fmpz_vec_clear(vals, count);
 
 		MessagePtr bm = newMsg();
-		bm->setDebugInfo("multiply commitments step 1 : " + cid1 + " * " + cid2);
-		//Let other parties know about our commitment multiplication
-		bm->addMultiplication(cid1, cid2, cid3, pid);
+		bm->setDebugInfo("multiply commitments step 1 : " + to_string(count) + " multiplication(s)");
+		//Let other parties know about our commitment multiplications
+		for (ulong j = 0; j < count; ++j) {
+			bm->addMultiplication(pairs[j].first, pairs[j].second, products[j], pid);
+		}
 		broadcast->broadcast(bm);
 	}
 	interact();
@@ -1905,24 +3519,27 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
 			PartyId sender = i + 1;
 			if (broadcast->hasMsg(sender)) {
 				vector<CommitmentMult> received = broadcast->recv(sender)->getMultiplications();
-				if (received.size() == 1) {
-					CommitmentMult receivedMult = received.back();
+				vector<CommitmentMult> accepted;
+				unordered_set<CommitmentId> cid3s;
+				for (auto const& receivedMult : received) {
 					CommitmentRecord* cr1_i = commitments->getRecord(receivedMult.cid1);
 					CommitmentRecord* cr2_i = commitments->getRecord(receivedMult.cid2);
 					CommitmentRecord* cr3_i = commitments->getRecord(receivedMult.cid3);
 					bool rec1Ok = (cr1_i != nullptr && cr1_i->getOwner() == sender);
 					bool rec2Ok = (cr2_i != nullptr && cr2_i->getOwner() == sender);
-					bool rec3Ok = (cr3_i != nullptr && cr3_i->getOwner() == sender);
-					if (rec1Ok && rec2Ok && rec3Ok) {
-						CommitmentMult newMult(receivedMult.cid1, receivedMult.cid2, receivedMult.cid3, sender);//ignore anything else the sent message contains
-						vecMult.push_back(newMult);
-					} else {
-						if (isCorrupt(pid)) {//we want to keep corrupt parties running until the end for debugging test cases. Here we prevent corrupted marking others as corrupt due to previously failed transfers.
-							continue;
-						}
-						addCorrupt(sender);//all honest will agree
+					bool rec3Ok = (cr3_i != nullptr && cr3_i->getOwner() == sender && cid3s.insert(receivedMult.cid3).second);
+					if (!(rec1Ok && rec2Ok && rec3Ok)) {
+						break;
 					}
+					CommitmentMult newMult(receivedMult.cid1, receivedMult.cid2, receivedMult.cid3, sender);//ignore anything else the sent message contains
+					accepted.push_back(newMult);
+				}
+				if (accepted.size() == received.size()) {
+					vecMult.insert(vecMult.end(), accepted.begin(), accepted.end());
 				} else {
+					if (isCorrupt(pid)) {//we want to keep corrupt parties running until the end for debugging test cases. Here we prevent corrupted marking others as corrupt due to previously failed transfers.
+						continue;
+					}
 					addCorrupt(sender);//all honest will agree
 				}
 			} else {
@@ -1933,25 +3550,31 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
 		fmpz_mod_poly_init(f, FIELD_PRIME);
 		fmpz_mod_poly_init(g, FIELD_PRIME);
 		fmpz_mod_poly_init(h, FIELD_PRIME);
-		mu->sampleUnivariate(f, cr1->getOpenedValue(), D);
-		mu->sampleUnivariate(g, cr2->getOpenedValue(), D);
-		fmpz_mod_poly_mul(h, f, g);
-		if (!MathUtil::degreeCheckEQ(h, 2*D)) {//sanity check
-			throw PceasException("Bad polynomial in commitment multiplication.");
-		}
-		//we commit to all coefficients(except x^0 coefficients val1, val2, val1*val2) of all 3 polynomials
-		for (ulong i = 1; i <= D; ++i) {
-			fmpz_mod_poly_get_coeff_fmpz(value, f, i);
-			commit(value, getCoeffCommitIdForMult(POLY_F, cid1, cid2, i));//INTERACTIVE
-		}
-		for (ulong i = 1; i <= D; ++i) {
-			fmpz_mod_poly_get_coeff_fmpz(value, g, i);
-			commit(value, getCoeffCommitIdForMult(POLY_G, cid1, cid2, i));//INTERACTIVE
-		}
-		for (ulong i = 1; i <= 2*D; ++i) {
-			fmpz_mod_poly_get_coeff_fmpz(value, h, i);
-			commit(value, getCoeffCommitIdForMult(POLY_H, cid1, cid2, i));//INTERACTIVE
+		//we commit to all coefficients(except x^0 coefficients val1, val2, val1*val2) of all 3 polynomials, for all multiplications, in a single batch
+		fmpz* coeffs = _fmpz_vec_init(4*D*count);
+		vector<CommitmentId> coeffIds;
+		for (auto const& pa : pairs) {
+			mu->sampleUnivariate(f, commitments->getRecord(pa.first)->getOpenedValue(), D);
+			mu->sampleUnivariate(g, commitments->getRecord(pa.second)->getOpenedValue(), D);
+			fmpz_mod_poly_mul(h, f, g);
+			if (!MathUtil::degreeCheckEQ(h, 2*D)) {//sanity check
+				throw PceasException("Bad polynomial in commitment multiplication.");
+			}
+			for (ulong i = 1; i <= D; ++i) {
+				fmpz_mod_poly_get_coeff_fmpz(coeffs+coeffIds.size(), f, i);
+				coeffIds.push_back(getCoeffCommitIdForMult(POLY_F, pa.first, pa.second, i));
+			}
+			for (ulong i = 1; i <= D; ++i) {
+				fmpz_mod_poly_get_coeff_fmpz(coeffs+coeffIds.size(), g, i);
+				coeffIds.push_back(getCoeffCommitIdForMult(POLY_G, pa.first, pa.second, i));
+			}
+			for (ulong i = 1; i <= 2*D; ++i) {
+				fmpz_mod_poly_get_coeff_fmpz(coeffs+coeffIds.size(), h, i);
+				coeffIds.push_back(getCoeffCommitIdForMult(POLY_H, pa.first, pa.second, i));
+			}
 		}
+		commit(coeffs, 4*D*count, coeffIds);//INTERACTIVE
+		_fmpz_vec_clear(coeffs, 4*D*count);
 		//No more commits will happen. We don't need to consider multiplications of corrupt players (for ex. those with with failed commitments). Mark their multiplications.
 		for (auto& m : vecMult) {
 			if (isCorrupt(m.owner)) {
@@ -1963,7 +3586,6 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
 		fmpz_mod_poly_clear(h);
 	}
 	{//Step3
-		CommitmentMult myMult;
 		/*
 		 * Now every coefficient is committed to, and every party can locally form commitments
 		 * to <f(k)> = cid + Ʃ ( k^i . <cid_coeff_i> ) using 'add' and 'scalarMult'.
@@ -1978,23 +3600,22 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
 					m.addHkx(k, combineCoeffCommitsForMult(POLY_H, m.cid3, m.cid1, m.cid2, k, 2*D));
 				}
 			}
-			if (m.owner == pid) {
-				myMult = m;
-			}
 		}
-		//'designatedOpen' shares for our multiplication
-		for (ulong i = 1; i < N; ++i) {//we start from i = 1, so that we don't open to self
-			PartyId k = getTargetForIteration(i);
-			if (!myMult.error) {
-				designatedOpen(myMult.getFkx(k), k);//INTERACTIVE
-				designatedOpen(myMult.getGkx(k), k);//INTERACTIVE
-				designatedOpen(myMult.getHkx(k), k);//INTERACTIVE
-			} else {//We will not 'designatedOpen' anything, but will participate in other's 'designatedOpen's.
-				designatedOpen(NONE, k);//INTERACTIVE
-				designatedOpen(NONE, k);//INTERACTIVE
-				designatedOpen(NONE, k);//INTERACTIVE
+		//'designatedOpen' shares for our multiplications (If we have none, we will not 'designatedOpen' anything, but will participate in other's 'designatedOpen's.)
+		//(all targets at once, we don't open to self)
+		vector< pair<CommitmentId, PartyId> > toOpen;
+		for (PartyId k = 1; k <= N; ++k) {
+			if (k != pid) {
+				for (auto const& m : vecMult) {
+					if (m.owner == pid && !m.error) {
+						toOpen.push_back(make_pair(m.getFkx(k), k));
+						toOpen.push_back(make_pair(m.getGkx(k), k));
+						toOpen.push_back(make_pair(m.getHkx(k), k));
+					}
+				}
 			}
 		}
+		designatedOpen(toOpen);//INTERACTIVE
 	}
 	{//Step 4
 		//For each ongoing multiplication of commitments, we will check consistency of commitments opened to us.
@@ -2052,32 +3673,24 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
 				}
 			}
 		}
-		//For any party who rejected our multiplication, we 'open' the shares which we 'designatedOpen'ed to them previously
+		//For any party who rejected one of our multiplications, we 'open' the shares which we 'designatedOpen'ed to them previously
 		//and we also participate in the open's of other parties
-		ulong maxNumberOfOpensPerParty = 0;// 'open's are done in parallel to reduce number of rounds (3 distinct opens for f,g,h counted as 1)
-		CommitmentMult myMult;
-		for (auto& m : vecMult) {
-			if (m.owner == pid) {
-				myMult = m;
-			}
+		bool anyOpens = false;// all 'open's are done in a single batched 'open' to reduce number of rounds
+		vector<CommitmentId> myOpens;
+		for (auto const& m : vecMult) {
 			if (!m.error) {
-				if (m.rejecters.size() > maxNumberOfOpensPerParty) {
-					maxNumberOfOpensPerParty = m.rejecters.size();
+				anyOpens = anyOpens || m.isRejected();
+				if (m.owner == pid) {
+					for (auto const& k : m.rejecters) {
+						myOpens.push_back(m.getFkx(k));
+						myOpens.push_back(m.getGkx(k));
+						myOpens.push_back(m.getHkx(k));
+					}
 				}
 			}
 		}
-		if (!myMult.error) {
-			for (auto const& k : myMult.rejecters) {
-				open(myMult.getFkx(k));//INTERACTIVE
-				open(myMult.getGkx(k));//INTERACTIVE
-				open(myMult.getHkx(k));//INTERACTIVE
-			}
-		}
-		ulong participations = (maxNumberOfOpensPerParty - (myMult.error ? 0 : myMult.rejecters.size()));
-		for (ulong i = 0; i < participations; ++i) {
-			open();//INTERACTIVE
-			open();//INTERACTIVE
-			open();//INTERACTIVE
+		if (anyOpens) {
+			open(myOpens);//INTERACTIVE
 		}
 		/*
 		 * Now that all rejected have been opened, every party can compare the opened values
@@ -2114,7 +3727,7 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
 		}
 	}
 	interact();
-	return cid3;
+	return products;
 }
 
 /**
@@ -2122,47 +3735,47 @@ CommitmentId Party::multiplyCommitments(CommitmentId cid1, CommitmentId cid2) {
  * to get a commitment to the party's share <f(k)> = cid + Ʃ ( k^i . <cid_coeff_i> )
  */
 CommitmentId Party::combineCoeffCommitsForTransfer(CommitmentId cid, ulong k, ulong transferSource, ulong transferTarget) {
-	CommitmentId combined = cid;//initialized with term_0
-	fmpz_t scalar;
-	fmpz_init_set_ui(scalar, 1);
+	vector<CommitmentId> cids;
+	cids.push_back(cid);//term_0
+	fmpz* scalars = _fmpz_vec_init(D + 1);
+	fmpz_one(scalars);
 	for (ulong i = 1; i <= D; ++i) {
-		fmpz_mul_ui(scalar,scalar,k); // k^i
-		fmpz_mod(scalar, scalar, FIELD_PRIME); // k^i
-		string cid_coeff_i = getCoeffCommitIdForTransfer(cid, transferSource, transferTarget, i);
-		string term_i = constMultCommitment(scalar, cid_coeff_i); // k^i . <cid_coeff_i>
-		combined = addCommitments(combined, term_i); // Ʃ
+		fmpz_mul_ui(scalars+i, scalars+i-1, k); // k^i
+		fmpz_mod(scalars+i, scalars+i, FIELD_PRIME); // k^i
+		cids.push_back(getCoeffCommitIdForTransfer(cid, transferSource, transferTarget, i));
 	}
-	fmpz_clear(scalar);
+	CommitmentId combined = linearCombineCommitments(scalars, cids, getCombinedCoeffCommitIdForTransfer(cid, k, transferSource, transferTarget)); // Ʃ k^i . <cid_coeff_i>
+	_fmpz_vec_clear(scalars, D + 1);
 	return combined;
 }
 
 CommitmentId Party::combineCoeffCommitsForMult(string polyName, CommitmentId cid, CommitmentId cid1, CommitmentId cid2, ulong k, ulong degree) {
-	CommitmentId combined = cid;//initialized with term_0
-	fmpz_t scalar;
-	fmpz_init_set_ui(scalar, 1);
+	vector<CommitmentId> cids;
+	cids.push_back(cid);//term_0
+	fmpz* scalars = _fmpz_vec_init(degree + 1);
+	fmpz_one(scalars);
 	for (ulong i = 1; i <= degree; ++i) {
-		fmpz_mul_ui(scalar,scalar,k); // k^i
-		fmpz_mod(scalar, scalar, FIELD_PRIME); // k^i
-		string cid_coeff_i = getCoeffCommitIdForMult(polyName, cid1, cid2, i);
-		string term_i = constMultCommitment(scalar, cid_coeff_i); // k^i . <cid_coeff_i>
-		combined = addCommitments(combined, term_i); // Ʃ
+		fmpz_mul_ui(scalars+i, scalars+i-1, k); // k^i
+		fmpz_mod(scalars+i, scalars+i, FIELD_PRIME); // k^i
+		cids.push_back(getCoeffCommitIdForMult(polyName, cid1, cid2, i));
 	}
-	fmpz_clear(scalar);
+	CommitmentId combined = linearCombineCommitments(scalars, cids, getCombinedCoeffCommitIdForMult(polyName, cid, cid1, cid2, k, degree)); // Ʃ k^i . <cid_coeff_i>
+	_fmpz_vec_clear(scalars, degree + 1);
 	return combined;
 }
 
 CommitmentId Party::combineCoeffCommitsForSharing(CommitmentId cid, ulong k) {
-	CommitmentId combined = cid;//initialized with term_0
-	fmpz_t scalar;
-	fmpz_init_set_ui(scalar, 1);
+	vector<CommitmentId> cids;
+	cids.push_back(cid);//term_0
+	fmpz* scalars = _fmpz_vec_init(D + 1);
+	fmpz_one(scalars);
 	for (ulong i = 1; i <= D; ++i) {
-		fmpz_mul_ui(scalar,scalar,k); // k^i
-		fmpz_mod(scalar, scalar, FIELD_PRIME); // k^i
-		string cid_coeff_i = getCoeffCommitIdForSharing(cid, i);
-		string term_i = constMultCommitment(scalar, cid_coeff_i); // k^i . <cid_coeff_i>
-		combined = addCommitments(combined, term_i); // Ʃ
+		fmpz_mul_ui(scalars+i, scalars+i-1, k); // k^i
+		fmpz_mod(scalars+i, scalars+i, FIELD_PRIME); // k^i
+		cids.push_back(getCoeffCommitIdForSharing(cid, i));
 	}
-	fmpz_clear(scalar);
+	CommitmentId combined = linearCombineCommitments(scalars, cids, getCombinedCoeffCommitIdForSharing(cid, k)); // Ʃ k^i . <cid_coeff_i>
+	_fmpz_vec_clear(scalars, D + 1);
 	return combined;
 }
 
@@ -2275,6 +3888,15 @@ CommitmentId Party::getConstMultCommitId(fmpz_t const& c, CommitmentId cid) cons
 	return commitid;
 }
 
+CommitmentId Party::getConstAddCommitId(fmpz_t const& c, CommitmentId cid) const {
+	CommitmentId commitid = "_(";
+	commitid += MathUtil::fmpzToStr(c);
+	commitid += "_+_";
+	commitid += cid;
+	commitid += ")_";
+	return commitid;
+}
+
 CommitmentId Party::getTransferedCommitId(CommitmentId id, PartyId source, PartyId target) const {
 	CommitmentId commitid = "_(transfered_";
 	commitid += id+"_";
@@ -2387,31 +4009,10 @@ CommitmentId Party::addCommitments(CommitmentId cid1, CommitmentId cid2) {
 		if (cr1->getOwner() != cr2->getOwner()) {
 			throw PceasException("Trying to add commitments with different owners.");
 		}
-		PartyId owner = cr1->getOwner();
-		CommitmentId cid3 = getAddedCommitId(cid1, cid2);
-		if (!commitments->exists(cid3)) {
-			commitments->addRecord(owner, cid3);
-		}
-		CommitmentRecord* cr3 = commitments->getRecord(cid3);
-		fmpz_t temp;
-		fmpz_init_set_ui(temp, 0);
-		fmpz_add(temp, cr1->getShare(), cr2->getShare());
-		fmpz_mod(temp, temp, FIELD_PRIME);//reduce
-		cr3->setShare(temp);
-		if (owner == pid) {
-			fmpz_mod_poly_t tempPoly;
-			fmpz_mod_poly_init(tempPoly, FIELD_PRIME);
-			fmpz_mod_poly_add(tempPoly, cr1->getfx_0(), cr2->getfx_0());
-			cr3->setfx_0(tempPoly);
-			fmpz_mod_poly_clear(tempPoly);
-			cr3->setOpenedValue(calculateZeroShare(cr3->getfx_0()));
-			// opened value could also be set as follows :
-//			fmpz_add(temp, cr1->getOpenedValue(), cr2->getOpenedValue());
-//			cr3->setOpenedValue(temp);
-		}
+		CommitmentRecord* cr3 = linearCombinationRecord(getAddedCommitId(cid1, cid2), cr1->getOwner());
+		cr3->setLinearCombination({CommitmentRecord::LinearTerm(1, cr1), CommitmentRecord::LinearTerm(1, cr2)});
 		cr3->setDone(cr1->isSuccess() && cr2->isSuccess());
-		fmpz_clear(temp);
-		return cid3;
+		return cr3->getCommitid();
 	}
 	throw PceasException("Trying addition with nonexisting commitment : "+cid1+"+"+cid2);
 }
@@ -2419,30 +4020,10 @@ CommitmentId Party::addCommitments(CommitmentId cid1, CommitmentId cid2) {
 CommitmentId Party::constMultCommitment(fmpz_t const& c, CommitmentId cid) {
 	CommitmentRecord* cr = commitments->getRecord(cid);
 	if (cr != nullptr) {
-		CommitmentId cid3 = getConstMultCommitId(c, cid);
-		if (!commitments->exists(cid3)) {
-			commitments->addRecord(cr->getOwner(), cid3);
-		}
-		CommitmentRecord* cr3 = commitments->getRecord(cid3);
-		fmpz_t temp;
-		fmpz_init_set_ui(temp, 0);
-		fmpz_mul(temp, c, cr->getShare());
-		fmpz_mod(temp, temp, FIELD_PRIME);//reduce
-		cr3->setShare(temp);
-		if (cr->getOwner() == pid) {
-			fmpz_mod_poly_t tempPoly;
-			fmpz_mod_poly_init(tempPoly, FIELD_PRIME);
-			fmpz_mod_poly_scalar_mul_fmpz(tempPoly, cr->getfx_0(), c);
-			cr3->setfx_0(tempPoly);
-			fmpz_mod_poly_clear(tempPoly);
-			cr3->setOpenedValue(calculateZeroShare(cr3->getfx_0()));
-			// opened value could also be set as follows :
-//			fmpz_mul(temp, c, cr->getOpenedValue());
-//			cr3->setOpenedValue(temp);
-		}
+		CommitmentRecord* cr3 = linearCombinationRecord(getConstMultCommitId(c, cid), cr->getOwner());
+		cr3->setLinearCombination({CommitmentRecord::LinearTerm(reduce(c), cr)});
 		cr3->setDone(cr->isSuccess());
-		fmpz_clear(temp);
-		return cid3;
+		return cr3->getCommitid();
 	}
 	throw PceasException("Trying scalar multiplication with nonexisting commitment : "+cid);
 }
@@ -2450,22 +4031,95 @@ CommitmentId Party::constMultCommitment(fmpz_t const& c, CommitmentId cid) {
 CommitmentId Party::constAddCommitment(fmpz_t const& c, CommitmentId cid) {
 	CommitmentRecord* cr = commitments->getRecord(cid);
 	if (cr != nullptr) {
-		CommitmentId tempCid = commitments->addRecord(cr->getOwner());
-		CommitmentRecord* tempCr = commitments->getRecord(tempCid);
-		publicCommit(tempCr, c);
-		tempCr->setDone(true);
-		return addCommitments(cid, tempCid);
+		//public commitment to 'c' is represented by a null record
+		CommitmentRecord* cr3 = linearCombinationRecord(getConstAddCommitId(c, cid), cr->getOwner());
+		cr3->setLinearCombination({CommitmentRecord::LinearTerm(1, cr), CommitmentRecord::LinearTerm(reduce(c), nullptr)});
+		cr3->setDone(cr->isSuccess());
+		return cr3->getCommitid();
 	}
 	throw PceasException("Trying scalar addition with nonexisting commitment : "+cid);
 }
 
 CommitmentId Party::substractCommitments(CommitmentId cid1, CommitmentId cid2) {
-	fmpz_t minusOne;
-	fmpz_init_set_si(minusOne, -1);
-	CommitmentId minusSecond = constMultCommitment(minusOne, cid2);
-	CommitmentId result = addCommitments(cid1, minusSecond);
-	fmpz_clear(minusOne);
-	return result;
+	CommitmentRecord* cr1 = commitments->getRecord(cid1);
+	CommitmentRecord* cr2 = commitments->getRecord(cid2);
+	if (cr1 != nullptr && cr2 != nullptr) {
+		if (cr1->getOwner() != cr2->getOwner()) {
+			throw PceasException("Trying to substract commitments with different owners.");
+		}
+		fmpz_t minusOne;
+		fmpz_init_set_si(minusOne, -1);
+		CommitmentRecord* cr3 = linearCombinationRecord(getAddedCommitId(cid1, getConstMultCommitId(minusOne, cid2)), cr1->getOwner());
+		cr3->setLinearCombination({CommitmentRecord::LinearTerm(1, cr1), CommitmentRecord::LinearTerm(reduce(minusOne), cr2)});
+		cr3->setDone(cr1->isSuccess() && cr2->isSuccess());
+		fmpz_clear(minusOne);
+		return cr3->getCommitid();
+	}
+	throw PceasException("Trying substraction with nonexisting commitment : "+cid1+"-"+cid2);
+}
+
+/**
+ * Computes <Ʃ c_i . cid_i + constant> as a single record (named 'resultCid', if given), instead of
+ * chaining 'constMultCommitment's, 'addCommitments' and 'constAddCommitment'. 'coeffs' holds one coefficient per commitment,
+ * 'constant' is reduced modulo p.
+ */
+CommitmentId Party::linearCombineCommitments(fmpz const* coeffs, vector<CommitmentId> const& cids, CommitmentId resultCid, ulong constant) {
+	if (cids.empty()) {
+		throw PceasException("Trying linear combination of no commitments.");
+	}
+	vector<CommitmentRecord::LinearTerm> terms;
+	bool success = true;
+	PartyId owner = NOPARTY;
+	for (ulong i = 0; i < cids.size(); ++i) {
+		CommitmentRecord* cr = commitments->getRecord(cids[i]);
+		if (cr == nullptr) {
+			throw PceasException("Trying linear combination with nonexisting commitment : "+cids[i]);
+		}
+		if (owner != NOPARTY && cr->getOwner() != owner) {
+			throw PceasException("Trying linear combination of commitments with different owners.");
+		}
+		owner = cr->getOwner();
+		terms.push_back(CommitmentRecord::LinearTerm(reduce(coeffs+i), cr));
+		success = success && cr->isSuccess();
+	}
+	if (constant != 0) {
+		terms.push_back(CommitmentRecord::LinearTerm(constant, nullptr));//public commitment to 'constant' is represented by a null record
+	}
+	if (resultCid == NONE) {
+		resultCid = commitments->addRecord(owner);
+	} else if (find(cids.begin(), cids.end(), resultCid) != cids.end()) {
+		if (terms.size() == 1 && terms.front().first == 1) {//identity, e.g. combining coefficients of a degree 0 polynomial
+			return resultCid;
+		}
+		throw PceasException("Linear combination would overwrite one of its operands : "+resultCid);
+	}
+	CommitmentRecord* result = linearCombinationRecord(resultCid, owner);
+	result->setLinearCombination(terms);
+	result->setDone(success);
+	return result->getCommitid();
+}
+
+/**
+ * Returns the record that will hold the result of a local (linear) operation on commitments.
+ * Result of the operation is not computed until it is needed (see CommitmentRecord::materialize).
+ */
+CommitmentRecord* Party::linearCombinationRecord(CommitmentId cid, PartyId owner) {
+	if (!commitments->exists(cid)) {
+		commitments->addRecord(owner, cid);
+	}
+	return commitments->getRecord(cid);
+}
+
+/**
+ * Returns 'c' reduced modulo p
+ */
+ulong Party::reduce(const fmpz* c) const {
+	fmpz_t temp;
+	fmpz_init(temp);
+	fmpz_mod(temp, c, FIELD_PRIME);
+	ulong reduced = fmpz_get_ui(temp);
+	fmpz_clear(temp);
+	return reduced;
 }
 
 /**
@@ -2487,6 +4141,87 @@ void Party::calculatePartyShares(fmpz_mod_poly_t const& f) {
 	fmpz_mod_poly_evaluate_fmpz_vec_fast(shares, f, multipointVec, N);
 }
 
+/**
+ * For each of the commitments being opened 'crs', counts the parties whose verifier is consistent with the received f(x,0),
+ * i.e. verifier of party k equals f(k,0). 'verifierOf' looks up the verifier party i+1 sent for a commitment.
+ *
+ * With batched verification, verifiers of a party are checked for all commitments at once : for random r_j,
+ * Ʃ r_j.f_j(k,0) is compared with Ʃ r_j.v_kj. If any of party k's verifiers is wrong, a single check passes
+ * with probability at most 1/p, so 'batchedVerificationRepetitions' = ceil(securityParameter / floor(log2 p)) checks,
+ * each with its own coefficients, are made. (The error probability is then at most 2^-(security parameter))
+ * Verifiers of a party who fails any check (or has not sent verifiers for all commitments) are checked one by one.
+ * The coefficients are derived from a hash of everything checked here (the f_j(x,0)s and all verifiers), not sampled locally.
+ * Parties who have the same f_j(x,0)s and verifiers (i.e. all honest parties, in 'open', where they are broadcast)
+ * therefore use the same coefficients and get the same counters, so they also agree on which commitments fail.
+ */
+vector<ulong> Party::countValidVerifiers(vector<CommitmentRecord*> const& crs, function<bool(ulong, CommitmentId const&, fmpz_t&)> const& verifierOf) {
+	const ulong M = crs.size();
+	vector<ulong> counters(M, 0);
+	const ulong R = (M > 1) ? batchedVerificationRepetitions : 0;
+	fmpz* verifiers = _fmpz_vec_init(N*M);//verifier of party i+1 for commitment j, at i*M+j
+	vector<bool> complete(N, true);//party sent verifiers for all commitments
+	ulong h = MathUtil::HASH_BASIS;
+	for (ulong j = 0; j < M; ++j) {
+		h = MathUtil::hash(h, crs[j]->getCommitid());
+		fmpz_mod_poly_t const& fx_0 = crs[j]->getfx_0();
+		for (slong c = 0; c <= fmpz_mod_poly_degree(fx_0); ++c) {
+			fmpz_mod_poly_get_coeff_fmpz(value, fx_0, c);
+			h = MathUtil::hash(h, fmpz_get_ui(value));
+		}
+	}
+	for (ulong i = 0; i < N; ++i) {
+		for (ulong j = 0; j < M; ++j) {
+			const bool sent = verifierOf(i, crs[j]->getCommitid(), value);
+			if (sent) {
+				fmpz_set(verifiers+i*M+j, value);
+			}
+			complete[i] = complete[i] && sent;
+			h = MathUtil::hash(h, sent ? fmpz_get_ui(verifiers+i*M+j) : fmpz_get_ui(FIELD_PRIME));//(p is not a field element, it marks a missing verifier)
+		}
+	}
+	flint_rand_t common;//coefficients all parties with the same inputs agree on
+	flint_randinit(common);
+	flint_randseed(common, h, MathUtil::hash(h, M));
+	fmpz* r = _fmpz_vec_init(R*M);//coefficients, for each repetition
+	fmpz* combinedShares = _fmpz_vec_init(R*N);//Ʃ r_j.f_j(k,0), for each repetition and each party k
+	fmpz_mod_poly_t term;
+	fmpz_mod_poly_init(term, FIELD_PRIME);
+	for (ulong t = 0; t < R; ++t) {
+		fmpz_mod_poly_zero(poly);
+		for (ulong j = 0; j < M; ++j) {
+			fmpz_randm(r+t*M+j, common, FIELD_PRIME);
+			fmpz_mod_poly_scalar_mul_fmpz(term, crs[j]->getfx_0(), r+t*M+j);
+			fmpz_mod_poly_add(poly, poly, term);
+		}
+		calculatePartyShares(poly);
+		_fmpz_vec_set(combinedShares+t*N, shares, N);
+	}
+	flint_randclear(common);
+	for (ulong i = 0; i < N; ++i) {
+		bool valid = complete[i] && R > 0;
+		for (ulong t = 0; t < R && valid; ++t) {
+			_fmpz_vec_dot(value, r+t*M, verifiers+i*M, M);
+			fmpz_mod(value, value, FIELD_PRIME);
+			valid = (fmpz_equal(value, combinedShares+t*N+i) != 0);
+		}
+		for (ulong j = 0; j < M; ++j) {
+			if (valid) {
+				counters[j]++;
+			} else if (verifierOf(i, crs[j]->getCommitid(), value)) {//temporarily store sent value in 'value'
+				calculatePartyShare(i, crs[j]->getfx_0());
+				if (fmpz_equal(value, shares+i) != 0) {//EQUAL
+					counters[j]++;
+				}
+			}
+		}
+	}
+	fmpz_mod_poly_clear(term);
+	_fmpz_vec_clear(combinedShares, R*N);
+	_fmpz_vec_clear(r, R*M);
+	_fmpz_vec_clear(verifiers, N*M);
+	return counters;
+}
+
 fmpz_t const& Party::calculateZeroShare(fmpz_mod_poly_t const& f) {
 	fmpz_t z;
 	fmpz_init_set_ui(z, 0);
@@ -2527,6 +4262,29 @@ void Party::calculateDelta(fmpz_mod_poly_t& delta, PartyId i) {
 	fmpz_clear(temp);
 }
 
+/**
+ * For each packed instance j, Lagrange coefficients of the parties for point -j (see 'setRecombinationVector')
+ */
+void Party::setPackedRecombinationVectors() {
+	const ulong K = packedInstances;
+	if (packedRecombinationVectors == nullptr) {
+		packedRecombinationVectors = _fmpz_vec_init(K*N);
+	}
+	fmpz_t x;
+	fmpz_init(x);
+	fmpz_mod_poly_t delta;
+	fmpz_mod_poly_init(delta, FIELD_PRIME);
+	for (PartyId i = 1; i <= N; ++i) {
+		calculateDelta(delta, i);
+		for (ulong j = 0; j < K; ++j) {
+			MathUtil::packedPoint(x, j+1, FIELD_PRIME);
+			fmpz_mod_poly_evaluate_fmpz(packedRecombinationVectors+j*N+i-1, delta, x);
+		}
+	}
+	fmpz_clear(x);
+	fmpz_mod_poly_clear(delta);
+}
+
 void Party::setRecombinationVector() {
 	fmpz_t temp, z;
 	fmpz_init(temp);
@@ -2581,6 +4339,14 @@ void Party::addSecret(string label, ulong val) {
 	secrets->addSecret(label, val);
 }
 
+void Party::addSecretUpdate(string label, ulong val) {
+	secretUpdates->addSecret(label, val);
+}
+
+void Party::addInstanceSecret(string label, vector<ulong> const& vals) {
+	secrets->addInstanceSecret(label, vals);
+}
+
 void Party::sanityChecks() {
 	if (N < 3) {
 		throw PceasException("Number of computing parties must be greater than 2.");
@@ -2606,6 +4372,13 @@ void Party::sanityChecks() {
 		 * are set as dishonest, computation will not complete.
 		 */
 		maxDishonest = C;
+		if (robustOutputReconstruction && N <= 3 * D) {
+			/*
+			 * Up to D output shares may be incorrect. Decoding corrects (N - D - 1) / 2 errors, which is at least D only when N > 3D.
+			 * Otherwise, decoding may succeed on a wrong polynomial, and honest parties would be reported as cheaters.
+			 */
+			throw PceasException("Threshold too large for robust output reconstruction : 3(T-1) < N is required.");
+		}
 	}
 	/**
 	 * Because we use Shamir's secret sharing scheme, field must be of size at least N + 1.
@@ -2624,6 +4397,14 @@ void Party::sanityChecks() {
 	if (!circuit) {
 		throw PceasException("Circuit not set.");
 	}
+	if (running == PCEPS_WITH_ABORT) {
+		if (2 * D >= N) {//needed for degree reduction. Then, shares of honest parties (more than D) determine each opened value
+			throw PceasException("Threshold too large : 2(T-1) < N is required.");
+		}
+		if (!randomizedCircuit) {
+			throw PceasException("Randomized circuit not set.");
+		}
+	}
 	if (circuit->getOutputCount() != 1) {//circuit must have single unconnected wire
 		/*
 		 * A simplifying assumption. To extend to circuits with multiple outputs,
@@ -2678,6 +4459,14 @@ void Party::print(stringstream& ss) {
 		}
 		cout << endl;
 	}
+	//print set of parties found to send incorrect output shares (data user only)
+	if (!outputCheaters.empty()) {
+		cout << endl << "Output cheaters : ";
+		for (auto const& p : outputCheaters) {
+			cout << to_string(p) << "\t";
+		}
+		cout << endl;
+	}
 	//print recombination vector
 	cout << endl << "Recombination vector : ";
 	for (ulong i = 0; i < N; ++i) {
@@ -2699,7 +4488,16 @@ void Party::print(stringstream& ss) {
 }
 
 MessagePtr Party::newMsg() const {
-	return MessagePtr(new Message(pid, FIELD_PRIME));
+	MessagePtr m(new Message(pid, FIELD_PRIME));
+	m->setSession(session);
+	return m;
+}
+
+/**
+ * Distinguishes results of concurrent sessions in the output
+ */
+string Party::resultTag() const {
+	return (session == 0) ? "" : " (session " + to_string(session) + ")";
 }
 
 bool Party::isCorrupt(PartyId p) const {
@@ -2715,36 +4513,6 @@ void Party::addCorrupt(PartyId p) {
 	setRecombinationVector();//recalculate recombination vector
 }
 
-/**
- * To run 'transfersCommitment's and 'designatedOpen's in parallel,
- * Party 1 transfers to Party 1+i, Party 2 transfers to Party 2+i, ...
- * Note : Such a scheme is required because each party can receive
- * at most one private message (and one broadcast) from any other party
- * in a single round (by definition of 'round').
- */
-PartyId Party::getTargetForIteration(ulong i) const {
-	PartyId k = (pid + i);
-	if (k > N) {
-		k = k - N;
-	}
-	return k;
-}
-
-/**
- * Find source from given 'target', using 'sampleSource' and 'sampleTarget',
- * such that both sample and newly found source-target pairs comply with the
- * target choosing scheme given in 'getTargetForIteration'.
- */
-PartyId Party::getSourceFromTarget(PartyId target, PartyId sampleSource, PartyId sampleTarget)  const{
-	const ulong positiveDiff = (sampleTarget > sampleSource) ? (sampleTarget - sampleSource) : ((N + sampleTarget) - sampleSource);
-	PartyId source = (target > positiveDiff) ? (target - positiveDiff) : ((N + target) - positiveDiff);
-	return source;
-}
-
-PartyId Party::getTargetFromSource(PartyId source, PartyId sampleSource, PartyId sampleTarget) const {
-	return getSourceFromTarget(source, sampleTarget, sampleSource);
-}
-
 const string Party::SHARE_PREFIX = "share";
 const string Party::TRIPLE_PREFIX = "triple";
 
@@ -28,13 +28,18 @@
 #define PARTY_H_
 
 #include <vector>
+#include <deque>
 #include <unordered_set>
 #include <unordered_map>
 #include <mutex>
+#include <functional>
+#include <fstream>
 #include <condition_variable>
 #include "Pceas.h"
 #include "CommitmentTable.h"
 #include "MultiplicationTriple.h"
+#include "BeaverTriple.h"
+#include "DoubleSharing.h"
 #include "Secrets.h"
 #include "../circuit/Circuit.h"
 #include "../communication/SecureChannel.h"
@@ -50,41 +55,93 @@ public:
 	Party(PartyId pid, ulong partyCount, ulong threshold, ulong fieldPrime);
 	virtual ~Party();
 	void runProtocol();
-	void runProtocolSequential(string prevRunResultLabel, Circuit* nextCircuit);
+	void runProtocolSequential(vector<string> resultLabels, vector<Circuit*> nextCircuits);
+	void runProtocolIncremental();
 private:
 	/** BEGIN Protocols implemented by the party **/
 	void runPceps();
+	void runPackedPceps();
+	void runPcepsWithAbort();
+	void runBatchPceps();
 	void runPceas(bool circuitRandomization, bool finalRun = true);
+	void shareInputs(function<string(ulong)> const& uniqueSuffixOf);
 	/** Subprotocols implemented by the party **/
 	//Secret Sharing
 	void distributeShares(fmpz_t const& val, string label = NONE);
+	void distributeShares(fmpz const* vals, ulong count);
+	void reduceDegree(fmpz* vals, ulong count, vector<GateNumber> const& gateNumbers);
+	bool openWithCheck(fmpz const* vals, ulong count, fmpz* opened);
+	//Packed Secret Sharing (for 'CEPS' over many instances)
+	void distributePackedShares(fmpz const* vals, string label = NONE);
+	void reducePackedDegree(fmpz_t& val);
+	void setPackedRecombinationVectors();
+	void reduceDegreeViaKing(fmpz* vals, ulong count, vector<GateNumber> const& gateNumbers);
+	void openViaKing(fmpz* vals, ulong count, string what);
+	void generateDoubleSharings(vector<GateNumber> const& gateNumbers);
+	//Preprocessing stage for 'CEPS' with Beaver triples
+	void generateBeaverTriples(vector<GateNumber> const& gateNumbers);
 	//Verifiable Secret Sharing (VSS)
 	void distributeVerifiableShares(fmpz_t const& val, string uniqueSuffix, string label = NONE, bool preprocessingPhase = false, bool inputSharingPhase = false);
 	void distributeVerifiableShares(CommitmentId cid, string uniqueSuffix, string label = NONE, bool preprocessingPhase = false, bool inputSharingPhase = false); // VSS from existing commitment
+	void distributeVerifiableShares(vector<CommitmentId> const& cids, vector<string> const& uniqueSuffixes, vector<string> const& labels, bool preprocessingPhase = false, bool inputSharingPhase = false); // batched VSS from existing commitments
+	void distributeVerifiableShares(vector<CommitmentId> const& cids, function<string(ulong)> const& uniqueSuffixOf, vector<string> const& labels, bool preprocessingPhase = false, bool inputSharingPhase = false, ulong maxCount = 0); // batched VSS, counts may differ between parties
 	//Preprocessing stage for 'CEAS with Circuit Randomization'
 	void runPreprocessing();
+	void generateTriples(vector<GateNumber> const& gateNumbers);
+	void runOfflinePreprocessing();
+	void writeTripleStockpileHeader(ostream& os, ulong tripleCount) const;
+	void saveTripleStockpile(vector<GateNumber> const& gateNumbers);
+	void loadTripleStockpile(vector<GateNumber> const& gateNumbers);
+	vector<CommitmentId> getTripleRecordNames(GateNumber gn) const;
+	//Output reconstruction without verification (error correction instead)
+	void reconstructOutputRobustly(CommitmentId result);
 	/** The 3 protocols below implement Fcom ideal functionality **/
 	//Protocol 'Protocol Perfect-Com-Simple'
 	CommitmentId commit(fmpz_t const& val, CommitmentId predeterminedCommitId = NONE);
+	vector<CommitmentId> commit(fmpz const* vals, ulong count, vector<CommitmentId> const& predeterminedCommitIds = vector<CommitmentId>());
 	void publicCommit(CommitmentRecord* cr, fmpz_t const& val);
 	void publicCommitToZero(CommitmentRecord* cr);
+	void concludeCommitments(vector<CommitmentId> const& cids);
 	void open(CommitmentId cid = NONE);
+	void open(vector<CommitmentId> const& commitids);
 	void designatedOpen(CommitmentId commitid, PartyId k, bool isOutputOpening = false);
+	void designatedOpen(vector<CommitmentId> const& commitids, PartyId k, bool isOutputOpening = false);
+	void designatedOpen(vector< pair<CommitmentId, PartyId> > const& opens, bool isOutputOpening = false);
 	CommitmentId addCommitments(CommitmentId cid1, CommitmentId cid2);
 	CommitmentId constMultCommitment(fmpz_t const& c, CommitmentId cid);
 	CommitmentId constAddCommitment(fmpz_t const& c, CommitmentId cid);
 	CommitmentId substractCommitments(CommitmentId cid1, CommitmentId cid2);
+	CommitmentId linearCombineCommitments(fmpz const* coeffs, vector<CommitmentId> const& cids, CommitmentId resultCid = NONE, ulong constant = 0);
+	CommitmentRecord* linearCombinationRecord(CommitmentId cid, PartyId owner);
+	ulong reduce(const fmpz* c) const;
 	//Protocol 'Perfect Transfer' (of commitment)
 	void transferCommitment(CommitmentId commitid, PartyId k);
+	void transferCommitment(vector<CommitmentId> const& commitids, PartyId k);
+	void transferCommitment(vector< pair<CommitmentId, PartyId> > const& transfers);
 	//Protocol 'Perfect Commitment Multiplication'
 	CommitmentId multiplyCommitments(CommitmentId cid1 = NONE, CommitmentId cid2 = NONE);
+	vector<CommitmentId> multiplyCommitments(vector< pair<CommitmentId, CommitmentId> > const& pairs);
 	/** END Protocols **/
 
+	/**
+	 * Output of a gate for party k : Ʃ c_i . <operand_i> + constant, computed with party k's commitments.
+	 * Operands are named as our own shares (see 'getShareNameFor').
+	 */
+	struct GateRecipe {
+		vector<ulong> coeffs;
+		vector<CommitmentId> operands;
+		ulong constant = 0;
+	};
+	void mirrorGateResult(Gate* g, function<GateRecipe(PartyId)> const& recipeFor);
+	CommitmentId assignGateResult(PartyId k, GateNumber gn, GateRecipe const& recipe);
+	void deriveMirroredRecord(CommitmentId cid);
+
 	void calculateDelta(fmpz_mod_poly_t& delta, PartyId i);
 	void setRecombinationVector();
-	CommitmentId runDegreeReduction(vector<CommitmentRecord*> const& shares, GateNumber gn);
+	GateRecipe runDegreeReduction(vector<CommitmentRecord*> const& shares) const;
 	CommitmentId sumShares(vector<CommitmentRecord*> const& shares, GateNumber gn, const char* multiplicandId);
 	void calculatePartyShare(ulong i, fmpz_mod_poly_t const& f);
+	vector<ulong> countValidVerifiers(vector<CommitmentRecord*> const& crs, function<bool(ulong, CommitmentId const&, fmpz_t&)> const& verifierOf);
 	void calculatePartyShares(fmpz_mod_poly_t const& f);
 	fmpz_t const& calculateZeroShare(fmpz_mod_poly_t const& poly);
 	CommitmentRecord* zeroShareFor(PartyId p, CommitmentId cid);
@@ -92,9 +149,6 @@ private:
 
 	bool isCorrupt(PartyId p) const;
 	void addCorrupt(PartyId p);
-	PartyId getTargetForIteration(ulong i) const;
-	PartyId getSourceFromTarget(PartyId target, PartyId sampleSource, PartyId sampleTarget) const;
-	PartyId getTargetFromSource(PartyId source, PartyId sampleSource, PartyId sampleTarget) const;
 	void sanityChecks();
 
 	PartyId pid;//party ID
@@ -112,6 +166,12 @@ private:
 	 * Corrupted parties will be excluded from recombination.
 	 */
 	unordered_set<PartyId> corrupted;
+	/**
+	 * Holds IDs of parties who sent an incorrect share of the output, found by the data user in robust output reconstruction.
+	 * Other parties can not verify this, so unlike 'corrupted', these are not agreed upon and are only used by the data user :
+	 * their shares are treated as missing in later output reconstructions. (see 'reconstructOutputRobustly')
+	 */
+	unordered_set<PartyId> outputCheaters;
 
 	fmpz* recombinationVector;
 	fmpz* shares; // temporary space for holding incoming and outgoing shares
@@ -123,6 +183,65 @@ private:
 	 */
 	unordered_map<GateNumber, MultiplicationTriple> triples;
 
+	/**
+	 * Committed wires that persist across the runs of a session (see 'runProtocolSequential') : label -> our share
+	 * Inputs are kept after the first run, and the result of each run is kept under the label given for it.
+	 */
+	unordered_map<string, CommitmentId> sessionWires;
+	void keepSessionWire(string label);
+
+	/**
+	 * Incremental re-evaluation (see 'runProtocolIncremental') : after the first run, only the inputs in 'secretUpdates'
+	 * are shared again, and only the gates depending on them are recomputed. Committed wires of all other gates are kept.
+	 */
+	Secrets* secretUpdates;
+	bool incrementalRun;
+	void prepareIncrementalRun();
+	void dropRecords(CommitmentId cid);
+
+	/**
+	 * Beaver triples, generated in preprocessing phase of 'CEPS' (if enabled)
+	 */
+	bool cepsBeaverTriples;
+	unordered_map<GateNumber, BeaverTriple> beaverTriples;
+
+	/**
+	 * If true, 'CEPS' reduces degrees via a king, using double sharings generated in preprocessing phase.
+	 * Otherwise, every party reshares its local products to everyone.
+	 */
+	bool kingDegreeReduction;
+	PartyId nextKing;
+	unordered_map<GateNumber, deque<DoubleSharing>> doubleSharings;//double sharings reserved for the degree reductions of each gate
+
+	/**
+	 * If greater than 1, 'CEPS' evaluates that many instances of the circuit in a single run,
+	 * with packed secret sharing (instance j is placed at point -j).
+	 * packedRecombinationVectors holds, for each instance j, the Lagrange coefficients of all parties for point -j.
+	 */
+	ulong packedInstances;
+	fmpz* packedRecombinationVectors;
+
+	/**
+	 * Batch evaluation for 'CEPS' : the circuit is evaluated for each of the 'batchRows' rows of inputs.
+	 * Rows are processed in chunks of batchCircuits.size() rows (a copy of the circuit for each row of a chunk),
+	 * with all rows of a chunk sharing the same rounds. The data user writes results to 'batchOutputPath'.
+	 */
+	vector<Circuit*> batchCircuits;
+	ulong batchRows;
+	string batchOutputPath;
+
+	/**
+	 * 'CEPS' with abort : a copy of the circuit, evaluated on r.x for each wire value x of 'circuit' (see 'runPcepsWithAbort')
+	 */
+	Circuit* randomizedCircuit;
+
+	/**
+	 * If true, records for other parties' shares of gate outputs are derived only when needed.
+	 * Holds the recipes for deriving them.
+	 */
+	bool onDemandMirroring;
+	unordered_map<GateNumber, function<GateRecipe(PartyId)>> deferredMirrors;
+
 	/**
 	 * Number of computing parties.
 	 */
@@ -151,6 +270,7 @@ private:
 	static constexpr const char SEPERATOR = '@';
 	static const string SHARE_PREFIX;
 	static const string TRIPLE_PREFIX;
+	static constexpr ulong TRIPLE_STOCKPILE_MAGIC = 0x5043454153545232;//"PCEASTR2"
 
 	CommitmentId getCoeffCommitIdForTransfer(CommitmentId cid, PartyId source, PartyId target, ulong coeff) const;
 	CommitmentId getCoeffCommitIdForMult(string polyName, CommitmentId cid1, CommitmentId cid2, ulong coeff) const;
@@ -164,6 +284,7 @@ private:
 	CommitmentId getMultipliedCommitId(CommitmentId cid1, CommitmentId cid2) const;
 	CommitmentId getAddedCommitId(CommitmentId cid1, CommitmentId cid2) const;
 	CommitmentId getConstMultCommitId(fmpz_t const& c, CommitmentId cid) const;
+	CommitmentId getConstAddCommitId(fmpz_t const& c, CommitmentId cid) const;
 	pair<CommitmentId, CommitmentId> getSortedPair(CommitmentId cid1, CommitmentId cid2) const;
 	CommitmentId getTransferedCommitId(CommitmentTransfer const& ct) const;
 	CommitmentId getTransferedCommitId(CommitmentId id, PartyId source, PartyId target) const;
@@ -200,24 +321,77 @@ public:
 	void setCircuit(Circuit* c) {
 		this->circuit = c;
 	}
+	void setRandomizedCircuit(Circuit* c) {
+		this->randomizedCircuit = c;
+	}
 	void setProtocol(Protocol p) {
 		this->running = p;
 	}
+	void setOnDemandMirroring(bool onDemand) {
+		this->onDemandMirroring = onDemand;
+	}
+	void setStatisticsFile(string path);
+	void setBatchedVerification(ulong securityParameter);
+	void setRobustOutputReconstruction(bool robust) {
+		this->robustOutputReconstruction = robust;
+	}
+	void setOptimisticCommitments(bool optimistic) {
+		this->optimisticCommitments = optimistic;
+	}
+	void setCepsBeaverTriples(bool beaver) {
+		this->cepsBeaverTriples = beaver;
+	}
+	void setKingDegreeReduction(bool king) {
+		this->kingDegreeReduction = king;
+	}
+	void setPackedInstances(ulong k) {
+		this->packedInstances = k;
+	}
+	void setBatchEvaluation(vector<Circuit*> const& circuits, ulong rows, string outputPath) {
+		this->batchCircuits = circuits;
+		this->batchRows = rows;
+		this->batchOutputPath = outputPath;
+	}
+	void setTripleStockpile(string path, ulong offlineTripleCount = 0) {
+		this->tripleStockpile = path;
+		this->offlineTripleCount = offlineTripleCount;
+	}
 	void addSecret(string label, ulong val);
+	void addSecretUpdate(string label, ulong val);
+	void addInstanceSecret(string label, vector<ulong> const& vals);
 	PartyId getDataUser() const {
 		return dataUser;
 	}
+	unordered_set<PartyId> const& getOutputCheaters() const {
+		return outputCheaters;
+	}
 	void setDataUser(PartyId dataUser) {
 		this->dataUser = dataUser;
 	}
 	void setDishonest() {
 		this->dishonest = true;
 	}
+	void setSession(SessionId session) {
+		this->session = session;
+	}
 	void print(stringstream& ss);
 private:
 	bool dishonest; // For simulating dishonest behaviour. Not required by the protocols.
 	PartyId dataUser; // evaluation result will be opened to this party.
+	SessionId session; // messages are tagged with the session, so that sessions of a party can share the rounds (see 'SessionMultiplexer')
+	string resultTag() const;
 	Secrets* secrets; // (Secret) inputs to the computation. Will be secret shared in the input sharing phase.
+	ofstream* statistics; // If set, commitment table statistics are written here, per phase and per gate.
+	void reportStatistics(string phase, GateNumber gn = Gate::NO_GATE);
+	/*
+	 * If set, multiplication triples are taken from (or, in offline mode, generated into) this file,
+	 * instead of being generated for the circuit in the preprocessing phase.
+	 */
+	string tripleStockpile;
+	ulong offlineTripleCount; // if > 0, only preprocessing is run, and this many triples are saved to 'tripleStockpile'
+	ulong batchedVerificationRepetitions; // if > 0, verifiers of opened commitments are checked via this many random linear combinations
+	bool robustOutputReconstruction; // if true, output shares are sent unverified, and the data user decodes them (see 'reconstructOutputRobustly')
+	bool optimisticCommitments; // if true, a 'commit' ends right after the disputes are broadcast, if there are none
 	MessagePtr newMsg() const;
 	void interact();
 	void end();
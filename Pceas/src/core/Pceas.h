@@ -68,6 +68,8 @@
 #define TEST_CASE_13
 #define TEST_CASE_14
 #define TEST_CASE_15
+#define TEST_CASE_16
+#define TEST_CASE_17
 #endif
 
 #ifdef TEST_CASE_1
@@ -120,18 +122,26 @@
 #ifdef TEST_CASE_15
 #define MULTIPLICATION_REJECT_VALID_MULTIPLICATION
 #endif
+#ifdef TEST_CASE_16
+#define OUTPUT_SEND_INVALID_SHARE
+#endif
+#ifdef TEST_CASE_17
+#define CEPS_WITH_ABORT_ADDITIVE_ATTACK
+#endif
 /* END Test Cases */
 
 typedef ulong PartyId;
 typedef std::string CommitmentId;
 typedef unsigned long GateNumber;
 typedef ulong SecretValue;
+typedef ulong SessionId;
 
 enum Protocol {
 	PROT_NONE,
 	PCEPS, // Protocol 'CEPS' (Circuit Evaluation with Passive Security)
 	PCEAS, // Protocol 'CEAS' (Circuit Evaluation with Active Security)
-	PCEAS_WITH_CIRCUIT_RANDOMIZATION // Protocol 'CEAS' with Circuit Randomization
+	PCEAS_WITH_CIRCUIT_RANDOMIZATION, // Protocol 'CEAS' with Circuit Randomization
+	PCEPS_WITH_ABORT // Protocol 'CEPS' with abort (Passive evaluation, cheating is detected before output delivery)
 };
 
 static constexpr const char* NONE = "";
@@ -42,6 +42,13 @@ void Secrets::addSecret(std::string label, SecretValue val) {
 	}
 }
 
+void Secrets::addInstanceSecret(std::string label, std::vector<SecretValue> const& vals) {
+	auto const& p = instanceSecretsMap.insert(std::pair<std::string, std::vector<SecretValue>>(label, vals));
+	if (!p.second) {
+		throw PceasException("Tried to insert secret with existing label : " + label);
+	}
+}
+
 SecretValue Secrets::getSecretWithLabel(std::string label) const {
 	auto it = secretsMap.find(label);
 	if (it == secretsMap.end()) {
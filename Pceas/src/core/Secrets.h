@@ -28,6 +28,7 @@
 #define SECRETS_H_
 
 #include <unordered_map>
+#include <vector>
 #include "Pceas.h"
 
 namespace pceas {
@@ -41,8 +42,13 @@ public:
 	const std::unordered_map<std::string, SecretValue>& getSecrets() const {
 		return secretsMap;
 	}
+	void addInstanceSecret(std::string label, std::vector<SecretValue> const& vals);
+	const std::unordered_map<std::string, std::vector<SecretValue>>& getInstanceSecrets() const {
+		return instanceSecretsMap;
+	}
 private:
 	std::unordered_map<std::string, SecretValue> secretsMap;//label - value pairs
+	std::unordered_map<std::string, std::vector<SecretValue>> instanceSecretsMap;//label - (value for each instance) pairs, for packed or batch evaluation
 };
 
 } /* namespace pceas */
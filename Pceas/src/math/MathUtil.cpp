@@ -26,6 +26,7 @@
 
 #include "MathUtil.h"
 #include <random>
+#include <stdexcept>
 
 namespace pceas {
 
@@ -73,6 +74,40 @@ void MathUtil::sampleUnivariate(fmpz_mod_poly_t& poly, fmpz_t const& coeffZero,
 	fmpz_clear(temp);
 }
 
+/**
+ * Packed secret sharing (Franklin-Yung)
+ * Prepare a polynomial of degree <= 'degree' such that :
+ * 	1. poly(-j) = secrets[j-1] for j = 1..k (the 'k' secrets being shared)
+ * 	2. Values at the remaining degree + 1 - k points -(k+1), ..., -(degree+1) are random
+ * Any 'degree' - k + 1 shares reveal nothing about the secrets.
+ * (Field must be larger than (number of parties + degree + 1), so that these points differ from the points of the parties)
+ */
+void MathUtil::samplePacked(fmpz_mod_poly_t& poly, fmpz const* secrets, ulong k, ulong degree) {
+	const fmpz* p = fmpz_mod_poly_modulus(poly);
+	fmpz* xs = _fmpz_vec_init(degree+1);
+	fmpz* ys = _fmpz_vec_init(degree+1);
+	for (ulong j = 0; j <= degree; ++j) {
+		packedPoint(xs+j, j+1, p);
+		if (j < k) {
+			fmpz_set(ys+j, secrets+j);
+		} else {
+			fmpz_randm(ys+j, state, p);
+		}
+	}
+	interpolate(poly, xs, ys, degree+1);
+	_fmpz_vec_clear(xs, degree+1);
+	_fmpz_vec_clear(ys, degree+1);
+}
+
+/**
+ * x = -j (mod p), the point at which the j'th secret of a packed sharing is placed (see 'samplePacked')
+ */
+void MathUtil::packedPoint(fmpz_t x, ulong j, fmpz const* p) {
+	fmpz_set_ui(x, j);
+	fmpz_neg(x, x);
+	fmpz_mod(x, x, p);
+}
+
 /**
  * Prepare a polynomial such that :
  * 	1. Coefficient of ^0 term (the secret being shared) is 'coeffZero'
@@ -106,6 +141,200 @@ bool MathUtil::degreeCheckLTE(fmpz_mod_poly_t const& poly, ulong requiredDegree)
 	return (dZero && requiredDegree >= 0) || (requiredDegree >= degree);//safe to compare signed/unsigned here because only neg. value fmpz_mod_poly_degree returns is -1(for 0-polynomial)
 }
 
+/**
+ * Reed-Solomon decoding (Gao's algorithm)
+ *
+ * Finds the polynomial 'f' of degree <= 'degree' with f(xs[i]) = ys[i] for all but at most
+ * (n - degree - 1) / 2 of the 'n' points (xs must be distinct). Returns false if there is no such polynomial.
+ * Modulus is taken from 'f'.
+ * 	1. g0 = Π (x - xs[i]), g1 = the interpolating polynomial, deg(g1) < n
+ * 	2. Run extended Euclidean algorithm on (g0, g1), until deg(g) < (n + degree + 1) / 2 for the remainder g = u.g0 + v.g1
+ * 	3. f = g / v, if v divides g and deg(f) <= degree
+ */
+bool MathUtil::decodeReedSolomon(fmpz_mod_poly_t& f, fmpz const* xs, fmpz const* ys, ulong n, ulong degree) {
+	std::lock_guard<std::mutex> guard(mut);
+	const fmpz* p = fmpz_mod_poly_modulus(f);
+	fmpz_mod_poly_t g0, g1, v0, v1, q, r, t, lin;
+	fmpz_mod_poly_init(g0, p);
+	fmpz_mod_poly_init(g1, p);
+	fmpz_mod_poly_init(v0, p);
+	fmpz_mod_poly_init(v1, p);
+	fmpz_mod_poly_init(q, p);
+	fmpz_mod_poly_init(r, p);
+	fmpz_mod_poly_init(t, p);
+	fmpz_mod_poly_init(lin, p);
+	fmpz_t c;
+	fmpz_init(c);
+	//g0 = Π (x - xs[i])
+	fmpz_mod_poly_set_coeff_ui(g0, 0, 1);
+	fmpz_mod_poly_set_coeff_ui(lin, 1, 1);
+	for (ulong i = 0; i < n; ++i) {
+		fmpz_neg(c, xs+i);
+		fmpz_mod(c, c, p);
+		fmpz_mod_poly_set_coeff_fmpz(lin, 0, c);
+		fmpz_mod_poly_mul(g0, g0, lin);
+	}
+	lagrange(g1, g0, xs, ys, n);//g1 = the interpolating polynomial
+	//partial extended Euclidean algorithm, only keeping track of the cofactors of g1
+	fmpz_mod_poly_set_coeff_ui(v1, 0, 1);//v0 = 0, v1 = 1
+	const slong bound = n + degree + 1;//stop when 2.deg(g1) < n + degree + 1
+	while (fmpz_mod_poly_is_zero(g1) == 0 && 2*fmpz_mod_poly_degree(g1) >= bound) {
+		fmpz_mod_poly_divrem(q, r, g0, g1);
+		fmpz_mod_poly_swap(g0, g1);
+		fmpz_mod_poly_swap(g1, r);//(g0, g1) = (g1, g0 mod g1)
+		fmpz_mod_poly_mul(t, q, v1);
+		fmpz_mod_poly_sub(t, v0, t);
+		fmpz_mod_poly_swap(v0, v1);
+		fmpz_mod_poly_swap(v1, t);//(v0, v1) = (v1, v0 - q.v1)
+	}
+	fmpz_mod_poly_divrem(q, r, g1, v1);
+	const bool decoded = (fmpz_mod_poly_is_zero(r) != 0) && (fmpz_mod_poly_degree(q) <= (slong) degree);
+	if (decoded) {
+		fmpz_mod_poly_set(f, q);
+	}
+	fmpz_clear(c);
+	fmpz_mod_poly_clear(g0);
+	fmpz_mod_poly_clear(g1);
+	fmpz_mod_poly_clear(v0);
+	fmpz_mod_poly_clear(v1);
+	fmpz_mod_poly_clear(q);
+	fmpz_mod_poly_clear(r);
+	fmpz_mod_poly_clear(t);
+	fmpz_mod_poly_clear(lin);
+	return decoded;
+}
+
+/**
+ * Finds the polynomial 'f' of degree < 'n' with f(xs[i]) = ys[i] for all i (xs must be distinct).
+ * Modulus is taken from 'f'.
+ */
+void MathUtil::interpolate(fmpz_mod_poly_t& f, fmpz const* xs, fmpz const* ys, ulong n) {
+	std::lock_guard<std::mutex> guard(mut);
+	const fmpz* p = fmpz_mod_poly_modulus(f);
+	fmpz_mod_poly_t g0, lin;
+	fmpz_mod_poly_init(g0, p);
+	fmpz_mod_poly_init(lin, p);
+	fmpz_t c;
+	fmpz_init(c);
+	//g0 = Π (x - xs[i])
+	fmpz_mod_poly_set_coeff_ui(g0, 0, 1);
+	fmpz_mod_poly_set_coeff_ui(lin, 1, 1);
+	for (ulong i = 0; i < n; ++i) {
+		fmpz_neg(c, xs+i);
+		fmpz_mod(c, c, p);
+		fmpz_mod_poly_set_coeff_fmpz(lin, 0, c);
+		fmpz_mod_poly_mul(g0, g0, lin);
+	}
+	lagrange(f, g0, xs, ys, n);
+	fmpz_clear(c);
+	fmpz_mod_poly_clear(g0);
+	fmpz_mod_poly_clear(lin);
+}
+
+/**
+ * f = Ʃ ys[i] . Π (x - xs[j]) / (xs[i] - xs[j]), j != i (Lagrange interpolation)
+ * 'g0' must be Π (x - xs[i]). Callers hold the lock.
+ */
+void MathUtil::lagrange(fmpz_mod_poly_t& f, fmpz_mod_poly_t const& g0, fmpz const* xs, fmpz const* ys, ulong n) {
+	const fmpz* p = fmpz_mod_poly_modulus(f);
+	fmpz_mod_poly_t q, r, lin;
+	fmpz_mod_poly_init(q, p);
+	fmpz_mod_poly_init(r, p);
+	fmpz_mod_poly_init(lin, p);
+	fmpz_t c, denom;
+	fmpz_init(c);
+	fmpz_init(denom);
+	fmpz_mod_poly_zero(f);
+	fmpz_mod_poly_set_coeff_ui(lin, 1, 1);
+	for (ulong i = 0; i < n; ++i) {
+		fmpz_neg(c, xs+i);
+		fmpz_mod(c, c, p);
+		fmpz_mod_poly_set_coeff_fmpz(lin, 0, c);
+		fmpz_mod_poly_divrem(q, r, g0, lin);//q = Π (x - xs[j]), j != i
+		fmpz_mod_poly_evaluate_fmpz(denom, q, xs+i);
+		fmpz_invmod(denom, denom, p);
+		fmpz_mul(c, denom, ys+i);
+		fmpz_mod(c, c, p);
+		fmpz_mod_poly_scalar_mul_fmpz(q, q, c);
+		fmpz_mod_poly_add(f, f, q);
+	}
+	fmpz_clear(c);
+	fmpz_clear(denom);
+	fmpz_mod_poly_clear(q);
+	fmpz_mod_poly_clear(r);
+	fmpz_mod_poly_clear(lin);
+}
+
+/**
+ * FNV-1a hash of 'u', continuing from hash value 'h' (start with HASH_BASIS).
+ * Not a cryptographic hash : it only has to map the same data to the same value for every party.
+ */
+ulong MathUtil::hash(ulong h, ulong u) {
+	for (ulong b = 0; b < sizeof(ulong); ++b) {
+		h ^= (u >> (8*b)) & 0xff;
+		h *= 1099511628211UL;
+	}
+	return h;
+}
+
+ulong MathUtil::hash(ulong h, std::string const& s) {
+	for (unsigned char c : s) {
+		h ^= c;
+		h *= 1099511628211UL;
+	}
+	return hash(h, s.size());
+}
+
+void MathUtil::writeUlong(std::ostream& os, ulong u) {
+	os.write(reinterpret_cast<const char*>(&u), sizeof(u));
+}
+
+ulong MathUtil::readUlong(std::istream& is) {
+	ulong u = 0;
+	if (!is.read(reinterpret_cast<char*>(&u), sizeof(u))) {
+		throw std::runtime_error("Unexpected end of input.");
+	}
+	return u;
+}
+
+/**
+ * Field elements are reduced modulo p, so each fits in a single word.
+ */
+void MathUtil::writeFmpz(std::ostream& os, fmpz_t const& c) {
+	writeUlong(os, fmpz_get_ui(c));
+}
+
+void MathUtil::readFmpz(std::istream& is, fmpz_t c) {
+	fmpz_set_ui(c, readUlong(is));
+}
+
+/**
+ * Written as the number of coefficients, followed by the coefficients (lowest degree first).
+ */
+void MathUtil::writePoly(std::ostream& os, fmpz_mod_poly_t const& poly) {
+	fmpz_t c;
+	fmpz_init(c);
+	const slong length = fmpz_mod_poly_length(poly);
+	writeUlong(os, length);
+	for (slong i = 0; i < length; ++i) {
+		fmpz_mod_poly_get_coeff_fmpz(c, poly, i);
+		writeFmpz(os, c);
+	}
+	fmpz_clear(c);
+}
+
+void MathUtil::readPoly(std::istream& is, fmpz_mod_poly_t& poly) {
+	fmpz_t c;
+	fmpz_init(c);
+	fmpz_mod_poly_zero(poly);
+	const ulong length = readUlong(is);
+	for (ulong i = 0; i < length; ++i) {
+		readFmpz(is, c);
+		fmpz_mod_poly_set_coeff_fmpz(poly, i, c);
+	}
+	fmpz_clear(c);
+}
+
 flint_rand_t& MathUtil::getRandState() {
 	return state;
 }
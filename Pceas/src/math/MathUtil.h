@@ -30,6 +30,7 @@
 #include <fmpz.h>
 #include <fmpz_mod_poly.h>
 #include <mutex>
+#include <iostream>
 #include "../core/Pceas.h"
 
 namespace pceas {
@@ -40,15 +41,31 @@ public:
 	virtual ~MathUtil();
 
 	void sampleUnivariate(fmpz_mod_poly_t& poly, fmpz_t const& coeffZero, ulong degree);
+	void samplePacked(fmpz_mod_poly_t& poly, fmpz const* secrets, ulong k, ulong degree);
+	static void packedPoint(fmpz_t x, ulong j, fmpz const* p);
 	static void zeroUnivariate(fmpz_mod_poly_t& poly, fmpz_t const& coeffZero);
 	static std::string fmpzToStr(fmpz_t const& c);
 	static bool degreeCheckEQ(fmpz_mod_poly_t const& poly, ulong requiredDegree);
 	static bool degreeCheckLTE(fmpz_mod_poly_t const& poly, ulong requiredDegree);
+	static bool decodeReedSolomon(fmpz_mod_poly_t& f, fmpz const* xs, fmpz const* ys, ulong n, ulong degree);
+	static void interpolate(fmpz_mod_poly_t& f, fmpz const* xs, fmpz const* ys, ulong n);
+	//binary (de)serialization of field elements and polynomials over the field (see 'Party::saveTripleStockpile')
+	static void writeUlong(std::ostream& os, ulong u);
+	static ulong readUlong(std::istream& is);
+	static void writeFmpz(std::ostream& os, fmpz_t const& c);
+	static void readFmpz(std::istream& is, fmpz_t c);
+	static void writePoly(std::ostream& os, fmpz_mod_poly_t const& poly);
+	static void readPoly(std::istream& is, fmpz_mod_poly_t& poly);
+	//hashing of public data, to derive randomness all parties agree on (see 'Party::countValidVerifiers')
+	static const ulong HASH_BASIS = 14695981039346656037UL;
+	static ulong hash(ulong h, ulong u);
+	static ulong hash(ulong h, std::string const& s);
 	flint_rand_t& getRandState();
 
 private:
 	flint_rand_t state;
 	static std::mutex mut;
+	static void lagrange(fmpz_mod_poly_t& f, fmpz_mod_poly_t const& g0, fmpz const* xs, fmpz const* ys, ulong n);
 };
 
 } /* namespace pceas */
@@ -40,6 +40,7 @@ Message::Message(PartyId sender, fmpz_t const& m) : sender(sender), verifiableSh
 	input = false;
 	inputLabel = NONE;
 	target = 0;
+	session = 0;
 }
 
 Message::~Message() {
@@ -130,6 +131,15 @@ bool Message::getDisputedValue(PartyId disputer, PartyId disputed, fmpz_t& val)
 	return false;
 }
 
+shared_ptr<Message> Message::getBatchMessage(CommitmentId cid) const {
+	for (auto const& bm : batchMessages) {
+		if (bm->getCommitId() == cid) {
+			return bm;
+		}
+	}
+	return nullptr;
+}
+
 /**
  * For inspecting message contents..
  */
@@ -138,6 +148,9 @@ void Message::printMsg() {//Print Broadcast Message
 		cout << debugInfo << endl;
 	}
 	cout << "Sent by Party " + to_string(sender) << endl;
+	if (session != 0) {
+		cout << "Session " + to_string(session) << endl;
+	}
 	if (!commitId.empty()) {
 		cout << "Commitment ID : " + commitId << endl;
 	}
@@ -202,6 +215,12 @@ void Message::printMsg() {//Print Broadcast Message
 			cout << "----" << endl;
 		}
 	}
+	if (!batchMessages.empty()) {
+		cout << "Batch of " << batchMessages.size() << " : " << endl;
+		for (auto const& bm : batchMessages) {
+			bm->printMsg();
+		}
+	}
 	cout << endl << "------------------------------------" << endl;
 }
 void Message::printMsg(ulong channel) {//Print Private Message
@@ -63,6 +63,12 @@ public:
 	PartyId getSender() const {
 		return sender;
 	}
+	SessionId getSession() const {
+		return session;
+	}
+	void setSession(SessionId session) {
+		this->session = session;
+	}
 	void setShare(const fmpz_t val) {
 		fmpz_set(share, val);
 	}
@@ -96,12 +102,13 @@ public:
 	const vector<CommitmentMult>& getMultiplications() const {
 		return multiplications;
 	}
-	const vector<Message>& getBatchMessages() const {
+	const vector<shared_ptr<Message>>& getBatchMessages() const {
 		return batchMessages;
 	}
-	void addBatchMessage(Message const& m) {
+	void addBatchMessage(shared_ptr<Message> m) {
 		this->batchMessages.push_back(m);
 	}
+	shared_ptr<Message> getBatchMessage(CommitmentId cid) const;
 	bool isSuccess() const {
 		return success;
 	}
@@ -134,6 +141,7 @@ public:
 	void printMsg(ulong channel);
 private:
 	PartyId sender; //party ID of sender.
+	SessionId session; //session (of the sender and receiver) the message belongs to. See 'SessionMultiplexer'
 	fmpz_t mod;
 
 	fmpz_t share;
@@ -170,7 +178,11 @@ private:
 
 	string debugInfo;
 
-	vector<Message> batchMessages;
+	/**
+	 * Messages for the individual items of a batched operation (for example, one per commitment
+	 * in a batched 'commit'), so that the whole batch is sent in a single round.
+	 */
+	vector<shared_ptr<Message>> batchMessages;
 };
 
 typedef shared_ptr<Message> MessagePtr;